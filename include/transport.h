@@ -19,7 +19,9 @@
 #ifndef TINY_TRANSPORT_HPP_
 #define TINY_TRANSPORT_HPP_
 
+#include "transport/FlowController.h"
 #include "transport/ReceiverResource.h"
+#include "transport/ReceiveDispatcher.h"
 #include "transport/SenderResource.h"
 #include "transport/TransportFactory.h"
 #include "transport/TransportInterface.h"
@@ -0,0 +1,189 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_FLOW_CONTROLLER_H_
+#define TRANSPORT_FLOW_CONTROLLER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <transport/SenderResource.h>
+
+namespace transport
+{
+
+/**
+ * Configuration of a FlowController.
+ *
+ * - bytes_per_second: rate at which the bucket is refilled.
+ *
+ * - burst_size: capacity of the bucket, the number of bytes that can be sent back to back.
+ *
+ * - queue_depth: messages each sender can have waiting for tokens. Sends beyond it fail.
+ *
+ * - period: period of the timer refilling the bucket and sending the waiting messages.
+ */
+struct FlowControllerConfig
+{
+    uint64_t bytes_per_second = 0;
+    uint32_t burst_size = 65536;
+    uint32_t queue_depth = 1024;
+    std::chrono::milliseconds period{1};
+};
+
+/**
+ * Bytes a FlowController may send, refilled at a constant rate up to the burst size.
+ * Not thread safe, FlowController calls it with its lock held.
+ */
+class TokenBucket
+{
+public:
+    TokenBucket(
+        uint64_t bytes_per_second,
+        uint32_t burst_size,
+        const std::chrono::steady_clock::time_point &now)
+        : bytes_per_second_(bytes_per_second)
+        , burst_size_(burst_size)
+        , tokens_(burst_size)
+        , last_refill_(now)
+    {
+    }
+
+    //! Adds the tokens earned since the last refill, up to the burst size.
+    void refill(
+        const std::chrono::steady_clock::time_point &now);
+
+    /**
+     * Takes the tokens of a message when available.
+     * A message bigger than the bucket goes through once the bucket is full, leaving it negative.
+     */
+    bool take(
+        uint32_t size)
+    {
+        if (tokens_ < size && tokens_ < burst_size_)
+        {
+            return false;
+        }
+        tokens_ -= size;
+        return true;
+    }
+
+    //! Returns the tokens of a message that could not be sent, up to the burst size.
+    void give_back(
+        uint32_t size)
+    {
+        tokens_ = std::min<int64_t>(tokens_ + size, burst_size_);
+    }
+
+    //! Available bytes. Negative after a message bigger than the bucket went through.
+    int64_t tokens() const
+    {
+        return tokens_;
+    }
+
+private:
+    uint64_t bytes_per_second_;
+    uint32_t burst_size_;
+    int64_t tokens_;
+    std::chrono::steady_clock::time_point last_refill_;
+};
+
+/**
+ * Token bucket limiting the throughput of the senders attached to it.
+ * A message is sent right away when the bucket holds enough tokens and its sender has nothing waiting,
+ * otherwise it is copied into the queue of its sender. The timer driving the controller refills the
+ * bucket and serves the queues in turn, one message per sender and round, so a bulk sender cannot
+ * starve the others sharing the controller. The timer only runs while messages are waiting.
+ * Tokens are taken with the lock of the controller held, the messages are sent once it is released.
+ * Created by TransportFactory::create_flow_controller.
+ * @ingroup NETWORK_MODULE
+ */
+class FlowController : public std::enable_shared_from_this<FlowController>
+{
+    friend class TransportFactory;
+    friend class FlowControlledSenderResource;
+
+public:
+    explicit FlowController(
+        const FlowControllerConfig &config);
+
+    ~FlowController();
+
+    /**
+     * Returns a sender sending through the given one at the pace of this controller.
+     * Messages queued when the returned sender is destroyed are discarded.
+     */
+    std::shared_ptr<SenderResource> attach(
+        const std::shared_ptr<SenderResource> &sender);
+
+    //! Number of queued messages discarded because their sender kept failing to send them.
+    uint64_t dropped() const;
+
+private:
+    struct Queue;
+
+    FlowController(
+        const FlowController &) = delete;
+    FlowController &operator=(
+        const FlowController &) = delete;
+
+    /**
+     * Refills the bucket and sends the waiting messages. Called by the timer.
+     * The timer must not block, so a message the sender cannot take right away stays at the head of its
+     * queue, and its tokens go back to the bucket, until the next tick. It is dropped after
+     * s_maxSendAttempts attempts, so that an unreachable destination does not stall its sender for good.
+     * @return false when no message is left waiting, the timer is then stopped.
+     */
+    bool on_timer();
+
+    /**
+     * Sends or queues a message of a sender.
+     * @param release Callback handed to the sender when the message is sent right away, invoked in place
+     * otherwise. May be nullptr.
+     */
+    bool send(
+        Queue &queue,
+        const octet *data,
+        uint32_t size,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback *release);
+
+    void remove(
+        const Queue *queue);
+
+    FlowControllerConfig config_;
+
+    //! Timer ticks a queued message is tried on before being dropped.
+    static constexpr uint32_t s_maxSendAttempts = 16;
+
+    mutable std::mutex mutex_;
+    TokenBucket bucket_;
+    std::vector<std::shared_ptr<Queue>> queues_;
+    //! Queue served first in the next round.
+    size_t next_;
+    //! Whether the timer runs, or has been asked to.
+    bool timer_running_;
+    uint64_t dropped_;
+
+    //! Starts the timer, from any thread. Set by TransportFactory::create_flow_controller.
+    std::function<void()> start_timer_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_FLOW_CONTROLLER_H_
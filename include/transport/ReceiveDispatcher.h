@@ -0,0 +1,76 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_RECEIVE_DISPATCHER_H_
+#define TRANSPORT_RECEIVE_DISPATCHER_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <transport/ReceiverResource.h>
+
+namespace transport
+{
+
+class ReceiveQueue;
+class ReceiveWorker;
+
+//! Default number of messages each receiver can have pending in a ReceiveDispatcher
+constexpr uint32_t s_defaultReceiveQueueDepth = 1024;
+
+/**
+ * Pool of worker threads running the receive callbacks of ReceiverResources, so that a slow
+ * consumer does not hold the loop that reads every other socket.
+ * Each attached receiver gets its own ordered queue, always serviced by the same worker.
+ * When the queue of a receiver is full, new messages for it are dropped and accounted in
+ * ReceiverStatistics::dispatch_drops.
+ * @ingroup NETWORK_MODULE
+ */
+class ReceiveDispatcher
+{
+public:
+    /**
+     * @param workers Number of worker threads.
+     * @param queue_depth Maximum number of pending messages per receiver, rounded up to a power of two.
+     */
+    ReceiveDispatcher(
+        uint32_t workers,
+        uint32_t queue_depth = s_defaultReceiveQueueDepth);
+
+    ~ReceiveDispatcher();
+
+    //! Creates a queue whose messages are handed to handler by one of the workers.
+    std::shared_ptr<ReceiveQueue> attach(
+        const MetadataReceiveCallback &handler);
+
+    //! Removes a queue, waiting for the worker to finish with it.
+    void detach(
+        const std::shared_ptr<ReceiveQueue> &queue);
+
+private:
+    ReceiveDispatcher(
+        const ReceiveDispatcher &) = delete;
+    ReceiveDispatcher &operator=(
+        const ReceiveDispatcher &) = delete;
+
+    std::vector<std::unique_ptr<ReceiveWorker>> workers_;
+
+    uint32_t queue_depth_;
+
+    std::atomic<uint32_t> next_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_RECEIVE_DISPATCHER_H_
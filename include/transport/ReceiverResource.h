@@ -15,11 +15,76 @@
 #ifndef TRANSPORT_RECEIVER_RESOURCE_H_
 #define TRANSPORT_RECEIVER_RESOURCE_H_
 
+#include <atomic>
 #include <functional>
-
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <transport/type.h>
 
 namespace transport
 {
+
+class ReceiveDispatcher;
+class ReceiveQueue;
+
+/**
+ * Kernel side view of the channel managed by a ReceiverResource.
+ * Used to size socket buffers and to decide when receivers must be sharded.
+ */
+struct ReceiverStatistics
+{
+    //! Cumulative number of datagrams dropped by the kernel because the socket queue was full.
+    uint32_t kernel_drops = 0;
+    //! Bytes currently waiting in the kernel socket queue.
+    uint32_t queued_bytes = 0;
+    //! Size of the kernel socket receive buffer.
+    uint32_t buffer_size = 0;
+    //! Messages dropped because the ReceiveDispatcher queue of the resource, or the mailbox bringing the
+    //! messages of its own process, was full.
+    uint32_t dispatch_drops = 0;
+    //! Messages a reliable receiver gave up on, because they were no longer available at the writer
+    //! or fell out of the reception window.
+    uint32_t lost_messages = 0;
+    //! Messages discarded by the origin filter, the echoes of the own multicast traffic.
+    uint32_t origin_drops = 0;
+    //! Datagrams dropped because they did not fit in the reception buffer of the channel.
+    uint32_t truncated_drops = 0;
+};
+
+/**
+ * Information collected by the transport along with a received message.
+ * Timestamps are expressed as time since the epoch of CLOCK_REALTIME, and are zero when not available.
+ */
+struct ReceiveMetadata
+{
+    //! Time at which the kernel received the datagram.
+    std::chrono::nanoseconds kernel_timestamp{0};
+    //! Time at which the NIC received the datagram. Requires hardware timestamping enabled on the interface.
+    std::chrono::nanoseconds hardware_timestamp{0};
+    //! Index of the interface the datagram arrived on, 0 when not available.
+    uint32_t interface_index = 0;
+};
+
+using ReceiveCallback = std::function<void(const unsigned char* data,
+                                    const uint32_t size,
+                                    const Locator& local_locator,
+                                    const Locator& remote_locator)>;
+
+using MetadataReceiveCallback = std::function<void(const unsigned char* data,
+                                    const uint32_t size,
+                                    const Locator& local_locator,
+                                    const Locator& remote_locator,
+                                    const ReceiveMetadata& metadata)>;
+
+//! Plain function receiving the messages of a channel along with a context, see register_direct_receiver.
+using DirectReceiveHandler = void (*)(void *context,
+                                    const unsigned char* data,
+                                    const uint32_t size,
+                                    const Locator& local_locator,
+                                    const Locator& remote_locator,
+                                    const ReceiveMetadata& metadata);
+
 /**
  * RAII object that encapsulates the Receive operation over one channel in an unknown transport.
  * A Receiver resource is always univocally associated to a transport channel; the
@@ -33,23 +98,26 @@ class ReceiverResource
     //! In doing so, it guarantees the transport and channel are in a valid state for
     //! this resource to exist.
     friend class TransportFactory;
+    //! Accounts the messages of this process it had to drop.
+    friend class IntraProcessMailbox;
 
 public:
     ReceiverResource(const Locator &locator,
                         uint32_t max_recv_buffer_size)
         : locator_(locator)
         , max_message_size_(max_recv_buffer_size)
+        , priority_(TrafficPriority::NORMAL)
         , recv_callback_(nullptr)
+        , metadata_callback_(nullptr)
         , locator_check_callback_(nullptr)
-
+        , direct_receiver_(nullptr)
+        , origin_offset_(0)
+        , origin_drops_(0)
+        , mailbox_drops_(0)
     {
     }
 
-    virtual ~ReceiverResource()
-    {
-        locator_check_callback_ = nullptr;
-        recv_callback_ = nullptr;
-    }
+    virtual ~ReceiverResource();
 
 public:
     /**
@@ -71,10 +139,65 @@ public:
      * @param receiver The message receiver to register.
      */
     virtual void register_receiver(
-        const std::function<void(const unsigned char* data,
-                                    const uint32_t size,
-                                    const Locator& local_locator,
-                                    const Locator& remote_locator)> &callback) = 0;
+        const ReceiveCallback &callback) = 0;
+
+    /**
+     * Register a callback that also receives the metadata of each message, such as the kernel
+     * receive timestamp. Transports not providing metadata deliver a default constructed one.
+     * @param callback The callback to register.
+     */
+    virtual void register_receiver(
+        const MetadataReceiveCallback &callback)
+    {
+        metadata_callback_ = callback;
+    }
+
+    /**
+     * Registers a plain function called with the messages, instead of the callbacks, so that no
+     * std::function is involved. Used by StaticReceiverResource. May be called while traffic flows,
+     * but not concurrently with itself; a message being handled may still reach the previous handler.
+     * @param handler Function receiving the messages, nullptr restores the callbacks.
+     * @param context Passed along to handler.
+     */
+    void register_direct_receiver(
+        DirectReceiveHandler handler,
+        void *context)
+    {
+        const DirectReceiver *receiver = nullptr;
+        if (handler)
+        {
+            direct_receivers_.emplace_back(new DirectReceiver{handler, context});
+            receiver = direct_receivers_.back().get();
+        }
+        direct_receiver_.store(receiver, std::memory_order_release);
+    }
+
+    /**
+     * Runs the callbacks of this resource on a worker of the given dispatcher instead of the loop thread.
+     * Messages are copied into a queue owned by this resource, and handled in reception order.
+     * Must be called before traffic starts flowing. Passing nullptr restores inline callbacks.
+     * @param dispatcher Dispatcher whose workers run the callbacks.
+     */
+    void set_dispatcher(
+        const std::shared_ptr<ReceiveDispatcher> &dispatcher);
+
+    /**
+     * Discards, before any callback runs, the messages carrying the given origin at the given offset,
+     * such as the GUID prefix of the participant in the header of its messages. Used to drop the echoes
+     * of the own multicast traffic looped back by the kernel.
+     * Must be called before traffic starts flowing. An empty origin disables the filter.
+     * @param offset Position of the origin in the messages.
+     * @param origin Bytes identifying the messages of this process.
+     */
+    void set_origin_filter(
+        uint32_t offset,
+        const std::vector<octet> &origin);
+
+    /**
+     * Returns the kernel statistics of the underlying channel.
+     * Transports unable to provide them report the kernel fields as zero.
+     */
+    virtual ReceiverStatistics statistics() const;
 
     inline uint32_t max_message_size() const
     {
@@ -86,6 +209,36 @@ public:
         return locator_;
     }
 
+    //! Priority class of the channel.
+    inline TrafficPriority priority() const
+    {
+        return priority_;
+    }
+
+    /**
+     * Changes the priority class of the channel. Transports scheduling their reads override it.
+     * Called from the thread of the loop of the channel.
+     */
+    virtual void set_priority(
+        TrafficPriority priority)
+    {
+        priority_ = priority;
+    }
+
+    //! Descriptor of the socket of the channel, -1 when it cannot be handed over to another process.
+    virtual int native_handle() const
+    {
+        return -1;
+    }
+
+    /**
+     * Stops reading the socket of the channel, which stays open. Used once the socket has been handed over
+     * to another process. Called from the thread of the loop of the channel.
+     */
+    virtual void stop_reading()
+    {
+    }
+
 protected:
     ReceiverResource() = delete;
     ReceiverResource(
@@ -93,13 +246,54 @@ protected:
     ReceiverResource &operator=(
         const ReceiverResource &) = delete;
 
+    /**
+     * Hands a received message to the registered callbacks, either inline or through the dispatcher.
+     * Called by the transports from the loop thread.
+     */
+    void deliver(
+        const unsigned char* data,
+        const uint32_t size,
+        const Locator& local_locator,
+        const Locator& remote_locator,
+        const ReceiveMetadata& metadata);
+
     Locator locator_;
     uint32_t max_message_size_;
-    std::function<void(const unsigned char* data,
-                            const uint32_t size,
-                            const Locator& local_locator,
-                            const Locator& remote_locator)> recv_callback_;
+    TrafficPriority priority_;
+    ReceiveCallback recv_callback_;
+    MetadataReceiveCallback metadata_callback_;
     std::function<bool(const Locator &)> locator_check_callback_;
+
+private:
+    //! Invokes the registered callbacks.
+    void invoke(
+        const unsigned char* data,
+        const uint32_t size,
+        const Locator& local_locator,
+        const Locator& remote_locator,
+        const ReceiveMetadata& metadata);
+
+    //! Handler registered with register_direct_receiver, along with its context.
+    struct DirectReceiver
+    {
+        DirectReceiveHandler handler;
+        void *context;
+    };
+
+    //! Current handler, swapped as a whole so that invoke never pairs a handler with another context.
+    std::atomic<const DirectReceiver *> direct_receiver_;
+    //! Every handler registered, kept until destruction since invoke may still be using a replaced one.
+    std::vector<std::unique_ptr<const DirectReceiver>> direct_receivers_;
+
+    std::shared_ptr<ReceiveDispatcher> dispatcher_;
+    std::shared_ptr<ReceiveQueue> queue_;
+
+    uint32_t origin_offset_;
+    std::vector<octet> origin_;
+    std::atomic<uint32_t> origin_drops_;
+
+    //! Messages of this process dropped because the mailbox of the loop was full.
+    std::atomic<uint32_t> mailbox_drops_;
 };
 
 } // namespace transport
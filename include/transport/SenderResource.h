@@ -29,6 +29,9 @@ using SendCallback = std::function<bool(
     const LocatorList &locators,
     const std::chrono::steady_clock::time_point &)>;
 
+//! Invoked with the buffer of a message once the transport no longer reads it.
+using BufferReleaseCallback = std::function<void(const octet *)>;
+
 /**
  * RAII object that encapsulates the Send operation over one chanel in an unknown transport.
  * A Sender resource is always univocally associated to a transport channel; the
@@ -65,8 +68,54 @@ public:
         return returned_value;
     }
 
+    /**
+     * Sends to a destination locator, letting the transport read the buffer after returning.
+     * Transports supporting zero-copy sends (see TransportDescriptorInterface::zerocopy_threshold_) hand
+     * the buffer of large messages to the kernel, which reads it while the datagrams are transmitted.
+     * The buffer must not be modified nor freed until release is invoked with it, which happens exactly
+     * once per call, from the sending thread when the message was copied or from the loop thread otherwise.
+     * @param release Callback invoked once the buffer can be reused.
+     * @return Success of the send operation.
+     */
+    virtual bool send(
+        const octet *data,
+        uint32_t dataLength,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback &release)
+    {
+        bool returned_value = send(data, dataLength, locators, max_blocking_time_point);
+        release(data);
+        return returned_value;
+    }
+
     virtual Locator locator() const = 0;
 
+    /**
+     * Enables or disables the delivery of the multicast messages of the channel to the receivers of
+     * this host (IP_MULTICAST_LOOP). The setting belongs to the socket, so it applies to every sender
+     * of the same locator.
+     * @return false when the channel does not support it.
+     */
+    virtual bool set_multicast_loopback(
+        bool enable)
+    {
+        (void)enable;
+        return false;
+    }
+
+    //! Priority class of the channel.
+    virtual TrafficPriority priority() const
+    {
+        return TrafficPriority::NORMAL;
+    }
+
+    //! Descriptor of the socket of the channel, -1 when it cannot be handed over to another process.
+    virtual int native_handle() const
+    {
+        return -1;
+    }
+
     virtual ~SenderResource() = default;
 
 protected:
@@ -0,0 +1,153 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_STATIC_RESOURCE_H_
+#define TRANSPORT_STATIC_RESOURCE_H_
+
+#include <chrono>
+#include <memory>
+#include <transport/type.h>
+#include <transport/SenderResource.h>
+#include <transport/ReceiverResource.h>
+#include <transport/TransportDescriptorInterface.h>
+
+namespace transport
+{
+
+class UDPTransportInterface;
+class UDPSenderResource;
+
+/**
+ * Resources of the transport of a descriptor type, used by the statically typed resources.
+ * Only the transports of the library have a specialization.
+ */
+template<typename Descriptor>
+struct StaticTransportTraits;
+
+template<>
+struct StaticTransportTraits<TransportDescriptor<UDPv4Descriptor>>
+{
+    using Transport = UDPTransportInterface;
+    using Sender = UDPSenderResource;
+    static constexpr int32_t kind = LOCATOR_KIND_UDPv4;
+};
+
+template<>
+struct StaticTransportTraits<TransportDescriptor<UDPv6Descriptor>>
+{
+    using Transport = UDPTransportInterface;
+    using Sender = UDPSenderResource;
+    static constexpr int32_t kind = LOCATOR_KIND_UDPv6;
+};
+
+/**
+ * Sender of a channel whose transport is known at compile time, built by
+ * TransportFactory::build_static_send_resources.
+ * Messages go straight to the socket of the channel through a direct call, without the std::function and
+ * the virtual calls of SenderResource, and without the layers build_send_resources adds on top of the
+ * transport: intra-process delivery, Unix domain sockets and flow controllers.
+ */
+template<typename Descriptor>
+class StaticSenderResource
+{
+    friend class TransportFactory;
+
+public:
+    /**
+     * Sends to the given locators, blocking until max_blocking_time_point at most.
+     * Same semantics as SenderResource::send.
+     */
+    bool send(
+        const octet *data,
+        uint32_t dataLength,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point);
+
+    Locator locator() const
+    {
+        return resource_->locator();
+    }
+
+    //! Resource of the channel, for the APIs taking a SenderResource.
+    std::shared_ptr<SenderResource> resource() const
+    {
+        return resource_;
+    }
+
+private:
+    explicit StaticSenderResource(
+        std::shared_ptr<SenderResource> resource);
+
+    std::shared_ptr<SenderResource> resource_;
+    typename StaticTransportTraits<Descriptor>::Sender *sender_;
+};
+
+/**
+ * Receiver of a channel whose transport is known at compile time, built by
+ * TransportFactory::build_static_receiver_resources.
+ * Messages are handed to a handler of any type through a plain function generated for that type,
+ * in which its call operator is inlined, instead of a std::function.
+ */
+template<typename Descriptor>
+class StaticReceiverResource
+{
+    friend class TransportFactory;
+
+public:
+    /**
+     * Registers the handler of the messages of the channel, called as
+     * handler(data, size, local_locator, remote_locator, metadata). It replaces the callbacks registered
+     * on resource(), and must outlive the channel. May be called while traffic flows.
+     * @param handler Handler of the messages.
+     */
+    template<typename Handler>
+    void register_receiver(
+        Handler &handler)
+    {
+        resource_->register_direct_receiver([](
+                    void *context,
+                    const unsigned char* data,
+                    const uint32_t size,
+                    const Locator& local_locator,
+                    const Locator& remote_locator,
+                    const ReceiveMetadata& metadata)
+        {
+            (*static_cast<Handler *>(context))(data, size, local_locator, remote_locator, metadata);
+        }, &handler);
+    }
+
+    Locator locator() const
+    {
+        return resource_->locator();
+    }
+
+    //! Resource of the channel, for the APIs taking a ReceiverResource.
+    std::shared_ptr<ReceiverResource> resource() const
+    {
+        return resource_;
+    }
+
+private:
+    explicit StaticReceiverResource(
+        std::shared_ptr<ReceiverResource> resource)
+        : resource_(resource)
+    {
+    }
+
+    std::shared_ptr<ReceiverResource> resource_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_STATIC_RESOURCE_H_
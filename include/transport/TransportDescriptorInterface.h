@@ -38,6 +38,23 @@ constexpr uint8_t s_defaultTTL = 1;
 constexpr uint32_t s_maximumMessageSize = 65500;
 //! Default maximum initial peers range
 constexpr uint32_t s_maximumInitialPeersRange = 4;
+//! Default upper bound for the adaptive receive buffer
+constexpr uint32_t s_maximumAdaptiveRecvBufferSize = 16 * 1024 * 1024;
+//! Default DSCP code point of high priority traffic (CS6, network control)
+constexpr uint8_t s_defaultHighPriorityDSCP = 48;
+//! Default SO_PRIORITY of high priority traffic, the highest one allowed without CAP_NET_ADMIN
+constexpr int32_t s_defaultHighPrioritySocketPriority = 6;
+
+/**
+ * Pacing of the datagrams of a transport by the kernel. Both modes rely on the fq qdisc
+ * (or etf for TXTIME) being configured on the outgoing interface.
+ */
+enum class KernelPacing
+{
+    NONE,        //!< No kernel pacing.
+    PACING_RATE, //!< SO_MAX_PACING_RATE on every send socket.
+    TXTIME       //!< Every datagram is stamped with its transmit time through SO_TXTIME / SCM_TXTIME.
+};
 
 /**
  * Virtual base class for the data type used to define transport configuration.
@@ -49,6 +66,41 @@ constexpr uint32_t s_maximumInitialPeersRange = 4;
  *
  * - max_initial_peers_range_: number of channels opened with each initial remote peer.
  *
+ * - send_buffer_size_, recv_buffer_size_: socket buffer sizes applied to every channel (0 keeps the OS default).
+ *
+ * - adaptive_recv_buffer_: grow the receive buffer of a channel, up to max_recv_buffer_size_,
+ *   every time the kernel reports dropped datagrams on it.
+ *
+ * - max_bytes_per_second_, max_burst_size_: token bucket shared by every sender of the transport
+ *   (0 leaves the transport unlimited).
+ *
+ * - kernel_pacing_, kernel_pacing_rate_: let the kernel pace the datagrams at kernel_pacing_rate_ bytes/s,
+ *   per socket with KernelPacing::PACING_RATE, for the whole transport with KernelPacing::TXTIME.
+ *
+ * - high_priority_dscp_, high_priority_socket_priority_: DSCP code point and SO_PRIORITY of the sockets
+ *   of TrafficPriority::HIGH channels.
+ *
+ * - connected_sockets_: number of connect()ed sockets kept for the most used unicast destinations
+ *   (0 sends everything through the shared sockets). Connected sockets send from an ephemeral port, so
+ *   they are only used by channels whose socket no receiver reads, whose destinations never reply to it.
+ *
+ * - zerocopy_threshold_: messages of at least this size sent with a release callback are sent with
+ *   MSG_ZEROCOPY (0 disables zero-copy sends). Zero-copy sends leave from an ephemeral port, so multicast
+ *   destinations and the channels whose socket a receiver reads are still copied.
+ *
+ * - interface_whitelist_, interface_blacklist_: interfaces the transport may use, by name, address or
+ *   CIDR block (such as 10.0.0.0/8). An empty whitelist allows every interface, the blacklist wins over it.
+ *   They apply to the addresses locators are normalized to, to sockets bound to a specific address,
+ *   and to multicast: when either list is set, groups are joined and multicast datagrams sent on every
+ *   allowed interface, otherwise on the default one.
+ *
+ * - multicast_sources_: addresses of the sources multicast groups are joined for (source-specific multicast,
+ *   empty joins for any source).
+ *
+ * - lazy_init_: do not wait for the enumeration of the interfaces of the host when the transport is
+ *   registered. The enumeration starts right away on the thread pool of the loop, and the first channel
+ *   opened waits for it if it has not finished yet.
+ *
  * @ingroup TRANSPORT_MODULE
  * */
 struct TransportDescriptorInterface : public std::enable_shared_from_this<TransportDescriptorInterface>
@@ -60,6 +112,17 @@ struct TransportDescriptorInterface : public std::enable_shared_from_this<Transp
         : send_buffer_size_(0)
         , recv_buffer_size_(0)
         , ttl_(s_defaultTTL)
+        , adaptive_recv_buffer_(false)
+        , max_recv_buffer_size_(s_maximumAdaptiveRecvBufferSize)
+        , max_bytes_per_second_(0)
+        , max_burst_size_(s_maximumMessageSize)
+        , kernel_pacing_(KernelPacing::NONE)
+        , kernel_pacing_rate_(0)
+        , high_priority_dscp_(s_defaultHighPriorityDSCP)
+        , high_priority_socket_priority_(s_defaultHighPrioritySocketPriority)
+        , connected_sockets_(0)
+        , zerocopy_threshold_(0)
+        , lazy_init_(false)
         , max_message_size_(maximumMessageSize)
         , max_initial_peers_range_(maximumInitialPeersRange)
     {
@@ -116,6 +179,20 @@ struct TransportDescriptorInterface : public std::enable_shared_from_this<Transp
         return (this->send_buffer_size_ == t.min_send_buffer_size() &&
                 this->recv_buffer_size_ == t.recv_buffer_size_ &&
                 this->ttl_ == t.ttl_ &&
+                this->adaptive_recv_buffer_ == t.adaptive_recv_buffer_ &&
+                this->max_recv_buffer_size_ == t.max_recv_buffer_size_ &&
+                this->max_bytes_per_second_ == t.max_bytes_per_second_ &&
+                this->max_burst_size_ == t.max_burst_size_ &&
+                this->kernel_pacing_ == t.kernel_pacing_ &&
+                this->kernel_pacing_rate_ == t.kernel_pacing_rate_ &&
+                this->high_priority_dscp_ == t.high_priority_dscp_ &&
+                this->high_priority_socket_priority_ == t.high_priority_socket_priority_ &&
+                this->connected_sockets_ == t.connected_sockets_ &&
+                this->zerocopy_threshold_ == t.zerocopy_threshold_ &&
+                this->interface_whitelist_ == t.interface_whitelist_ &&
+                this->interface_blacklist_ == t.interface_blacklist_ &&
+                this->multicast_sources_ == t.multicast_sources_ &&
+                this->lazy_init_ == t.lazy_init_ &&
                 this->max_message_size_ == t.max_message_size() &&
                 this->max_initial_peers_range_ == t.max_initial_peers_range());
     }
@@ -126,6 +203,34 @@ struct TransportDescriptorInterface : public std::enable_shared_from_this<Transp
     uint32_t recv_buffer_size_;
     //! Specified time to live (8bit - 255 max TTL)
     uint8_t ttl_;
+    //! Grow the receive buffer when the kernel drops datagrams.
+    bool adaptive_recv_buffer_;
+    //! Upper bound of the receive buffer when adaptive_recv_buffer_ is enabled.
+    uint32_t max_recv_buffer_size_;
+    //! Throughput allowed to the senders of the transport, 0 for unlimited.
+    uint64_t max_bytes_per_second_;
+    //! Bytes the senders of the transport can send back to back.
+    uint32_t max_burst_size_;
+    //! Pacing done by the kernel.
+    KernelPacing kernel_pacing_;
+    //! Rate of the kernel pacing in bytes/s.
+    uint64_t kernel_pacing_rate_;
+    //! DSCP code point of the high priority sockets.
+    uint8_t high_priority_dscp_;
+    //! SO_PRIORITY of the high priority sockets, values above 6 require CAP_NET_ADMIN.
+    int32_t high_priority_socket_priority_;
+    //! Connected sockets kept for hot destinations. Datagrams sent through them leave from an ephemeral port.
+    uint32_t connected_sockets_;
+    //! Size from which messages are sent without copying them into the kernel, 0 to disable.
+    uint32_t zerocopy_threshold_;
+    //! Interfaces the transport may use.
+    std::vector<std::string> interface_whitelist_;
+    //! Interfaces the transport never uses.
+    std::vector<std::string> interface_blacklist_;
+    //! Sources multicast groups are joined for.
+    std::vector<std::string> multicast_sources_;
+    //! Enumerate the interfaces in the background instead of during the registration.
+    bool lazy_init_;
 
     //! Maximum size of a single message in the transport
     uint32_t max_message_size_;
@@ -182,6 +287,34 @@ public:
     virtual int32_t transport_kind() const override;
 };
 
+/**
+ * Unix domain datagram transport, for peers running on the same host.
+ * The channel listening on a port is named after it: "tiny-transport.<port>" in the abstract
+ * namespace on Linux, a socket file in /tmp elsewhere.
+ * Once registered, UDP channels also listen on their Unix domain name and UDP destinations on
+ * the local host are reached through it.
+ */
+struct UDSDescriptor
+{
+
+};
+template<>
+class TransportDescriptor<UDSDescriptor> : public TransportDescriptorInterface
+{
+public:
+    TransportDescriptor()
+    : TransportDescriptorInterface(s_maximumMessageSize, s_maximumInitialPeersRange)
+    {
+
+    }
+
+    virtual ~TransportDescriptor(){}
+public:
+    virtual TransportInterface *create_transport(std::shared_ptr<uvw::loop> loop) const override;
+
+    virtual int32_t transport_kind() const override;
+};
+
 } // namespace transport
 
 #endif // TRANSPORT_TRANSPORT_DESCRIPTOR_INTERFACE_H_
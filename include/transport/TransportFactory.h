@@ -15,11 +15,17 @@
 #ifndef TRANSPORT_NETWORK_FACTORY_H_
 #define TRANSPORT_NETWORK_FACTORY_H_
 
+#include <chrono>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <vector>
 #include <transport/type.h>
 #include <transport/TransportInterface.h>
 #include <transport/TransportDescriptorInterface.h>
+#include <transport/FlowController.h>
+#include <transport/StaticResource.h>
 
 namespace uvw
 {
@@ -29,6 +35,58 @@ class loop;
 namespace transport
 {
 
+class LoopPool;
+struct IntraProcessView;
+class IntraProcessMailbox;
+class ChannelDemultiplexer;
+
+/**
+ * Policy used to assign new channels to the loops of a TransportFactory owning several loops.
+ */
+enum class LoopPolicy
+{
+    ROUND_ROBIN,  //!< Loops are used in turn.
+    LEAST_LOADED, //!< The loop with the fewest channels is used.
+    AFFINITY      //!< The loop requested by the caller is used, round robin when none is requested.
+};
+
+/**
+ * Configuration of the loops owned by a TransportFactory.
+ *
+ * - size: number of loops, each one run by its own thread.
+ *
+ * - policy: how new sender and receiver channels are spread across the loops.
+ *
+ * - pin_threads: pin the thread of loop i to CPU i.
+ */
+struct LoopPoolConfig
+{
+    uint32_t size = 1;
+    LoopPolicy policy = LoopPolicy::ROUND_ROBIN;
+    bool pin_threads = false;
+};
+
+/**
+ * Configuration of the reliable channels built by a TransportFactory.
+ *
+ * - history_depth: number of sent messages each writer keeps for retransmission.
+ *
+ * - window_depth: number of out of order messages each reader holds per writer while waiting for the missing ones.
+ *
+ * - heartbeat_period: period at which writers announce their last sequence number, so that readers
+ *   detect the loss of the last messages of a burst.
+ *
+ * - writer_timeout: time after which readers forget a writer they have not heard from, along with its
+ *   window. A writer coming back afterwards is handled as a new one.
+ */
+struct ReliabilityConfig
+{
+    uint32_t history_depth = 256;
+    uint32_t window_depth = 256;
+    std::chrono::milliseconds heartbeat_period{100};
+    std::chrono::milliseconds writer_timeout{10000};
+};
+
 /**
  * Provides the TRANSPORT library with abstract resources, which
  * in turn manage the SEND and RECEIVE operations over some transport.
@@ -41,6 +99,13 @@ class TransportFactory
 public:
     explicit TransportFactory(std::shared_ptr<uvw::loop> loop = nullptr);
 
+    /**
+     * Creates a factory owning its own loops. Every channel is assigned to one of them according
+     * to the configured policy, and its callbacks are invoked from the thread running that loop.
+     * @param config Loop pool configuration.
+     */
+    explicit TransportFactory(const LoopPoolConfig &config);
+
     ~TransportFactory();
     /**
      * Allow registration of a transport dynamically.
@@ -54,20 +119,173 @@ public:
     /**
      * Walk over the list of transports, opening every possible channel that can send through
      * the given locator and returning a vector of Sender Resources associated with it.
+     * Unicast destinations listened to by a receiver built by this factory are served in process:
+     * the message is handed to the receiver from the sending thread (or queued on its ReceiveDispatcher)
+     * without going through the transport.
      * @param locator Locator through which to send.
+     * @param loop_affinity Loop requested for the channel when the factory owns several loops
+     * with LoopPolicy::AFFINITY. Negative lets the factory choose.
      */
     std::shared_ptr<SenderResource> build_send_resources(
-        const Locator &locator);
+        const Locator &locator,
+        int32_t loop_affinity = -1);
+
+    /**
+     * build_send_resources for a channel of the given priority class.
+     * High priority channels, meant for metatraffic, do not share the socket of the user data and
+     * are marked for the network (see TransportDescriptorInterface::high_priority_dscp_).
+     * @param locator Locator through which to send.
+     * @param priority Priority class of the channel.
+     * @param loop_affinity Loop requested for the channel, see build_send_resources.
+     */
+    std::shared_ptr<SenderResource> build_send_resources(
+        const Locator &locator,
+        TrafficPriority priority,
+        int32_t loop_affinity = -1);
+
+    /**
+     * Chooses, among the locators announced by a peer, the one reached through the cheapest transport:
+     * a receiver built by this factory, then shared memory, then a Unix domain socket, then UDP to an
+     * address of this host, then the network. Locality is decided with the interface table of the host.
+     * Only locators supported by a registered transport are considered, ties keep the announced order.
+     * @param peer_locators Locators announced by the peer.
+     * @param[out] selected Chosen locator.
+     * @return false when no locator can be reached.
+     */
+    bool select_locator(
+        const LocatorList &peer_locators,
+        Locator &selected) const;
+
+    /**
+     * Builds a channel able to reach a peer through its cheapest locator (see select_locator).
+     * The channel is bound to an ephemeral port, callers should keep the returned resource.
+     * @param peer_locators Locators announced by the peer.
+     * @param[out] selected Destination to pass to SenderResource::send.
+     * @param loop_affinity Loop requested for the channel, see build_send_resources.
+     */
+    std::shared_ptr<SenderResource> build_send_resources(
+        const LocatorList &peer_locators,
+        Locator &selected,
+        int32_t loop_affinity = -1);
 
     /**
      * Walk over the list of transports, opening every possible channel that we can listen to
      * from the given locator, and returns a vector of Receiver Resources for this goal.
      * @param local Locator from which to listen.
      * @param receiver_max_message_size Max message size allowed by the message receiver.
+     * @param loop_affinity Loop requested for the channel when the factory owns several loops
+     * with LoopPolicy::AFFINITY. Negative lets the factory choose.
+     */
+    std::shared_ptr<ReceiverResource> build_receiver_resources(
+        Locator &local,
+        uint32_t receiver_max_message_size,
+        int32_t loop_affinity = -1);
+
+    /**
+     * build_receiver_resources for a channel of the given priority class.
+     * The loop reads the high priority channels before the normal ones in every iteration, so metatraffic
+     * is not held back by bulk data arriving at the same time.
+     * @param local Locator from which to listen.
+     * @param receiver_max_message_size Max message size allowed by the message receiver.
+     * @param priority Priority class of the channel.
+     * @param loop_affinity Loop requested for the channel, see build_receiver_resources.
      */
     std::shared_ptr<ReceiverResource> build_receiver_resources(
         Locator &local,
-        uint32_t receiver_max_message_size);
+        uint32_t receiver_max_message_size,
+        TrafficPriority priority,
+        int32_t loop_affinity = -1);
+
+    /**
+     * Builds the sender of a channel of the transport of a descriptor type known at compile time,
+     * such as TransportDescriptor<UDPv4Descriptor>. See StaticSenderResource.
+     * @param locator Locator through which to send, of the kind of the transport.
+     * @param loop_affinity Loop requested for the channel, see build_send_resources.
+     * @return nullptr when the locator is of another kind or the transport is not registered.
+     */
+    template<typename Descriptor>
+    std::shared_ptr<StaticSenderResource<Descriptor>> build_static_send_resources(
+        const Locator &locator,
+        int32_t loop_affinity = -1);
+
+    /**
+     * Builds the receiver of a channel of the transport of a descriptor type known at compile time.
+     * The channel is the one build_receiver_resources returns. See StaticReceiverResource.
+     * @param local Locator from which to listen, of the kind of the transport.
+     * @param receiver_max_message_size Max message size allowed by the message receiver.
+     * @param loop_affinity Loop requested for the channel, see build_receiver_resources.
+     */
+    template<typename Descriptor>
+    std::shared_ptr<StaticReceiverResource<Descriptor>> build_static_receiver_resources(
+        Locator &local,
+        uint32_t receiver_max_message_size,
+        int32_t loop_affinity = -1);
+
+    /**
+     * Builds the sender of a logical channel multiplexed on the channel of the given locator.
+     * Messages carry a small header with the channel id, so that the receiving side can route them.
+     * @param locator Locator through which to send.
+     * @param channel_id Logical channel.
+     * @param loop_affinity Loop requested for the channel, see build_send_resources.
+     */
+    std::shared_ptr<SenderResource> build_channel_send_resources(
+        const Locator &locator,
+        uint32_t channel_id,
+        int32_t loop_affinity = -1);
+
+    /**
+     * Builds the receiver of a logical channel multiplexed on the socket of the given locator.
+     * All the logical channels of a locator share a single socket, and each one gets only the
+     * messages sent through build_channel_send_resources with its id.
+     * A locator is used either through logical channels or through build_receiver_resources, not both.
+     * @param local Locator from which to listen.
+     * @param channel_id Logical channel.
+     * @param receiver_max_message_size Max message size allowed by the message receiver.
+     * @param loop_affinity Loop requested for the socket, see build_receiver_resources. Only used by
+     * the first logical channel of the locator.
+     */
+    std::shared_ptr<ReceiverResource> build_channel_receiver_resources(
+        Locator &local,
+        uint32_t channel_id,
+        uint32_t receiver_max_message_size,
+        int32_t loop_affinity = -1);
+
+    /**
+     * Builds the writer of a reliable channel on the given locator. Messages carry a sequence number
+     * and are kept in a history, from which the ones reported missing by the readers are sent again.
+     * The locator must be unicast with an explicit port, and not be used by any receiver: readers send
+     * their NACKs to the socket of the channel.
+     * @param locator Locator through which to send.
+     * @param config Reliability configuration.
+     * @param loop_affinity Loop requested for the channel, see build_send_resources.
+     */
+    std::shared_ptr<SenderResource> build_reliable_send_resources(
+        const Locator &locator,
+        const ReliabilityConfig &config = ReliabilityConfig(),
+        int32_t loop_affinity = -1);
+
+    /**
+     * Builds the reader of a reliable channel. Messages of every writer are delivered in order,
+     * and the missing ones are requested to their writer.
+     * A locator is used either by reliable readers or through build_receiver_resources, not both.
+     * @param local Locator from which to listen.
+     * @param receiver_max_message_size Max message size allowed by the message receiver.
+     * @param config Reliability configuration.
+     * @param loop_affinity Loop requested for the channel, see build_receiver_resources.
+     */
+    std::shared_ptr<ReceiverResource> build_reliable_receiver_resources(
+        Locator &local,
+        uint32_t receiver_max_message_size,
+        const ReliabilityConfig &config = ReliabilityConfig(),
+        int32_t loop_affinity = -1);
+
+    /**
+     * Creates a flow controller driven by a timer of the first loop of the factory.
+     * Senders are attached to it with FlowController::attach.
+     * @param config Flow controller configuration.
+     */
+    std::shared_ptr<FlowController> create_flow_controller(
+        const FlowControllerConfig &config);
 
     void normalize_locators(
         LocatorList &locators);
@@ -121,11 +339,191 @@ public:
      */
     void update_network_interfaces();
 
+    /**
+     * Hands the sockets of the channels of this factory over to the process replacing it, which gets them
+     * with adopt_sockets. Blocks until that process connects to the Unix domain socket at the given path.
+     * Once the sockets are handed over, the receivers of this process stop reading them, so that the queued
+     * datagrams go to the adopting process. The senders keep working until the channels are shut down.
+     * Only the channels of transports supporting it (UDP) are handed over.
+     * @param path Path of the Unix domain socket, replaced if it exists.
+     * @param timeout Maximum time to wait for the adopting process.
+     */
+    bool export_sockets(
+        const std::string &path,
+        std::chrono::milliseconds timeout);
+
+    /**
+     * Takes over the sockets of the process being replaced, exported with export_sockets.
+     * Receivers and senders built afterwards on the same locators use them as they are: no bind happens,
+     * multicast groups are not joined again, and the datagrams queued in the sockets are not lost.
+     * Sockets no channel claims are closed along with their transport.
+     * Must be called after the transports are registered, and before building the channels.
+     * @param path Path of the Unix domain socket the other process exports to.
+     * @param timeout Maximum time to wait for the other process to export its sockets.
+     * @return false when nothing was received or some socket could not be adopted.
+     */
+    bool adopt_sockets(
+        const std::string &path,
+        std::chrono::milliseconds timeout);
+
 private:
+    /**
+     * Chooses the loop of a new channel, and reserves it for the locator. Every channel of a locator, and
+     * the socket adopted for it, use the same loop, so that they share the socket of the transport of
+     * that loop. Called with mutex_ held.
+     */
+    size_t select_loop(
+        int32_t loop_affinity,
+        const Locator &locator);
+
+    //! select_loop taking mutex_.
+    size_t select_loop_locked(
+        int32_t loop_affinity,
+        const Locator &locator);
+
+    /**
+     * Adds the channel a transport opened to the resource list, and records it so that it is accounted on
+     * its loop and closed there when the factory goes away. Called with mutex_ held.
+     */
+    void track_sender(
+        size_t loop_index,
+        const std::shared_ptr<SenderResource> &sender);
+
+    //! track_sender for receivers.
+    void track_receiver(
+        size_t loop_index,
+        const std::shared_ptr<ReceiverResource> &receiver);
+
+    /**
+     * Opens the output channel of a locator on the thread of its loop. mutex_ is only taken there to copy
+     * and update the resource list, never while waiting for the loop, so that loop callbacks may use the
+     * factory. Called without mutex_ held.
+     * @return whether the channel is open, it may have been opened before.
+     */
+    bool open_sender_on(
+        TransportInterface &transport,
+        const Locator &locator,
+        size_t loop_index,
+        TrafficPriority priority);
+
+    //! open_sender_on for input channels.
+    bool open_receiver_on(
+        TransportInterface &transport,
+        const Locator &locator,
+        uint32_t receiver_max_message_size,
+        size_t loop_index);
+
+    //! Creates the intra-process mailbox of every loop.
+    void open_mailboxes();
+
+    //! Closes the channels and transports of a loop. Runs on the thread of the loop.
+    void close_loop(
+        size_t loop_index);
+
+    std::shared_ptr<uvw::loop> loop_at(
+        size_t loop_index) const;
+
+    //! build_send_resources on a given loop. Called without mutex_ held.
+    std::shared_ptr<SenderResource> build_send_resources_on(
+        const Locator &locator,
+        size_t loop_index,
+        TrafficPriority priority = TrafficPriority::NORMAL);
+
+    //! build_receiver_resources on a given loop. Called without mutex_ held.
+    std::shared_ptr<ReceiverResource> build_receiver_resources_on(
+        const Locator &locator,
+        uint32_t receiver_max_message_size,
+        size_t loop_index,
+        TrafficPriority priority = TrafficPriority::NORMAL);
+
+    //! Returns the transport of the given kind running on the given loop of the pool. Called with mutex_ held.
+    TransportInterface *transport_on_loop(
+        int32_t kind,
+        size_t loop_index);
+
+    //! transport_on_loop taking mutex_.
+    TransportInterface *transport_on_loop_locked(
+        int32_t kind,
+        size_t loop_index);
+
+    /**
+     * Opens the local channel of an UDP receiver, named after its address and port, when the UDS transport
+     * is registered, so that local senders can reach the receiver without going through the IP stack.
+     */
+    void listen_on_uds(
+        const std::shared_ptr<ReceiverResource> &receiver,
+        size_t loop_index);
+
+    /**
+     * Hands a message to the receiver of this factory listening on the destination, if any.
+     * The message is copied and delivered on the loop of the receiver.
+     * Lock free, called by the senders from any thread.
+     */
+    bool deliver_intra_process(
+        const octet *data,
+        uint32_t size,
+        const Locator &destination,
+        const Locator &source) const;
+
+    /**
+     * Publishes a new view of the receivers and local addresses. Called with mutex_ held.
+     * @param new_receiver Receiver to add, nullptr to only refresh the addresses.
+     * @param loop_index Loop of the receiver, unless its channel is already assigned to one.
+     */
+    void update_intra_process_view(
+        const std::shared_ptr<ReceiverResource> &new_receiver,
+        size_t loop_index);
+
+    //! Runs the task on the thread of the given loop, or in place when the factory owns no loops.
+    void run_on_loop(
+        size_t loop_index,
+        const std::function<void()> &task);
+
     std::shared_ptr<uvw::loop> loop_;
 
+    std::unique_ptr<LoopPool> loop_pool_;
+
+    LoopPolicy loop_policy_;
+
+    /**
+     * Protects the transport and channel bookkeeping. Never held while waiting for a loop: channels are
+     * opened on the loop threads, which take it themselves.
+     */
+    std::mutex mutex_;
+
+    //! Transports bound to loop_, which is the first loop of the pool when the factory owns loops.
     std::vector<std::unique_ptr<TransportInterface>> registered_transports_;
 
+    //! Transports bound to the remaining loops of the pool, indexed by loop index - 1.
+    std::vector<std::vector<std::unique_ptr<TransportInterface>>> pooled_transports_;
+
+    //! Receivers built by this factory and addresses of this host, replaced as a whole on every change.
+    std::shared_ptr<const IntraProcessView> intra_process_view_;
+
+    //! Messages sent to the receivers of this factory, by loop index.
+    std::vector<std::shared_ptr<IntraProcessMailbox>> mailboxes_;
+
+    //! Flow controllers shared by every sender of a transport, by transport kind.
+    std::map<int32_t, std::shared_ptr<FlowController>> transport_flow_controllers_;
+
+    //! Loop of the channels of each locator, and of the sockets adopted from another process.
+    std::map<Locator, size_t> channel_loops_;
+
+    //! Channel opened by this factory, with the loop it runs on.
+    struct OpenedChannel
+    {
+        size_t loop_index;
+        std::shared_ptr<SenderResource> sender;
+        std::shared_ptr<ReceiverResource> receiver;
+    };
+    std::vector<OpenedChannel> opened_channels_;
+
+    //! UDP receivers whose local channel is open.
+    std::set<Locator> local_channels_;
+
+    //! Dispatch tables of the sockets shared by logical channels, by locator.
+    std::map<Locator, std::shared_ptr<ChannelDemultiplexer>> demultiplexers_;
+
     uint32_t max_message_size_between_transports_;
 
     uint32_t min_send_buffer_size_;
@@ -34,6 +34,20 @@ using SendResourceList = std::vector<std::shared_ptr<SenderResource>>;
 
 using ReceiverResourceList = std::vector<std::shared_ptr<ReceiverResource>>;
 
+/**
+ * Socket of a channel handed over to another process, see TransportFactory::export_sockets.
+ */
+struct HandoffSocket
+{
+    //! Locator of the channel.
+    Locator locator;
+    //! Whether the socket belongs to a receiver or to a sender.
+    bool input = false;
+    //! Priority class of the channel.
+    TrafficPriority priority = TrafficPriority::NORMAL;
+    //! Descriptor of the socket.
+    int fd = -1;
+};
 
 class TransportDescriptorInterface;
 /**
@@ -95,6 +109,17 @@ public:
         SendResourceList &sender_resource_list,
         const Locator &) = 0;
 
+    //! Opens an output channel of the given priority class. Transports without priority classes
+    //! open a normal channel.
+    virtual bool open_output_channel(
+        SendResourceList &sender_resource_list,
+        const Locator &locator,
+        TrafficPriority priority)
+    {
+        (void)priority;
+        return open_output_channel(sender_resource_list, locator);
+    }
+
     /** Opens an input channel to receive incoming connections.
      *   If there is an existing channel it registers the receiver interface.
      */
@@ -112,7 +137,8 @@ public:
     virtual LocatorList normalize_locator(
         const Locator &locator) = 0;
 
-    // virtual TransportDescriptorInterface *get_configuration() = 0;
+    //! Returns the descriptor this transport was created from.
+    virtual TransportDescriptorInterface *get_configuration() = 0;
 
     //! Add metatraffic multicast locator with the given port
     virtual bool default_metatraffic_multicast_locators(
@@ -157,6 +183,19 @@ public:
 
     virtual int32_t kind() const = 0;
 
+    /**
+     * Takes over a socket handed over by another process. The channel opened later on the same locator,
+     * direction and priority uses it as is, without binding nor joining its multicast groups again.
+     * Called from the thread of the loop of the transport.
+     * @return false when the transport does not support it, the descriptor is then left to the caller.
+     */
+    virtual bool adopt_socket(
+        const HandoffSocket &socket)
+    {
+        (void)socket;
+        return false;
+    }
+
 protected:
     TransportInterface()
     {
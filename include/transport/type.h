@@ -73,6 +73,18 @@ using octet = unsigned char;
 #define LOCATOR_KIND_TCPv6 8
 /// Shared memory locator kind
 #define LOCATOR_KIND_SHM 16
+/// Unix domain datagram socket locator kind
+#define LOCATOR_KIND_UDS 32
+
+/**
+ * Priority class of a channel. High priority channels use sockets of their own, marked for the network,
+ * and their receivers are read before the normal ones in every iteration of the loop.
+ */
+enum class TrafficPriority
+{
+    NORMAL, //!< User data.
+    HIGH    //!< Metatraffic, such as discovery and heartbeats.
+};
 
 /**
  * @brief Class Locator, uniquely identifies a communication channel for a particular transport.
@@ -162,6 +174,8 @@ public:
      * LOCATOR_KIND_TCPv6
      *
      * LOCATOR_KIND_SHM
+     *
+     * LOCATOR_KIND_UDS
      */
     int32_t kind;
     /// Network port
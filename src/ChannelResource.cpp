@@ -0,0 +1,186 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ChannelResource.cpp
+ *
+ */
+
+#include "ChannelResource.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace transport
+{
+
+static void write_channel_header(
+    uint32_t channel_id,
+    octet *header)
+{
+    header[0] = static_cast<octet>(s_channelHeaderMagic >> 8);
+    header[1] = static_cast<octet>(s_channelHeaderMagic & 0xFF);
+    header[2] = 0;
+    header[3] = 0;
+    header[4] = static_cast<octet>(channel_id >> 24);
+    header[5] = static_cast<octet>(channel_id >> 16);
+    header[6] = static_cast<octet>(channel_id >> 8);
+    header[7] = static_cast<octet>(channel_id);
+}
+
+static bool read_channel_header(
+    const octet *data,
+    uint32_t size,
+    uint32_t &channel_id)
+{
+    if (size < s_channelHeaderSize ||
+            data[0] != static_cast<octet>(s_channelHeaderMagic >> 8) ||
+            data[1] != static_cast<octet>(s_channelHeaderMagic & 0xFF))
+    {
+        return false;
+    }
+
+    channel_id = (static_cast<uint32_t>(data[4]) << 24) | (static_cast<uint32_t>(data[5]) << 16) |
+            (static_cast<uint32_t>(data[6]) << 8) | static_cast<uint32_t>(data[7]);
+    return true;
+}
+
+ChannelReceiverResource::ChannelReceiverResource(
+    std::shared_ptr<ReceiverResource> network_receiver,
+    uint32_t channel_id)
+    : ReceiverResource(network_receiver->locator(),
+            std::max(network_receiver->max_message_size(), s_channelHeaderSize) - s_channelHeaderSize)
+    , network_receiver_(network_receiver)
+    , channel_id_(channel_id)
+{
+    locator_check_callback_ = [this](const Locator &locatorToCheck) -> bool
+    {
+        return network_receiver_->support_locator(locatorToCheck);
+    };
+}
+
+void ChannelReceiverResource::register_receiver(
+    const ReceiveCallback &callback)
+{
+    recv_callback_ = callback;
+}
+
+ReceiverStatistics ChannelReceiverResource::statistics() const
+{
+    ReceiverStatistics stats = network_receiver_->statistics();
+    ReceiverStatistics own = ReceiverResource::statistics();
+    stats.dispatch_drops = own.dispatch_drops;
+    stats.origin_drops = own.origin_drops;
+    return stats;
+}
+
+std::shared_ptr<ChannelReceiverResource> ChannelDemultiplexer::channel(
+    const std::shared_ptr<ReceiverResource> &network_receiver,
+    uint32_t channel_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::shared_ptr<ChannelReceiverResource> receiver = channels_[channel_id].lock();
+    if (!receiver)
+    {
+        receiver = std::make_shared<ChannelReceiverResource>(network_receiver, channel_id);
+        channels_[channel_id] = receiver;
+    }
+
+    return receiver;
+}
+
+void ChannelDemultiplexer::dispatch(
+    const unsigned char* data,
+    const uint32_t size,
+    const Locator& local_locator,
+    const Locator& remote_locator,
+    const ReceiveMetadata& metadata)
+{
+    uint32_t channel_id = 0;
+    std::shared_ptr<ChannelReceiverResource> receiver;
+
+    if (read_channel_header(data, size, channel_id))
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = channels_.find(channel_id);
+        if (it != channels_.end())
+        {
+            receiver = it->second.lock();
+        }
+    }
+
+    if (!receiver)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    receiver->deliver(data + s_channelHeaderSize, size - s_channelHeaderSize, local_locator, remote_locator,
+            metadata);
+}
+
+ChannelSenderResource::ChannelSenderResource(
+    std::shared_ptr<SenderResource> network_sender,
+    uint32_t channel_id)
+    : SenderResource()
+    , network_sender_(network_sender)
+{
+    send_lambda_ = [this, channel_id](
+                        const octet *data,
+                        uint32_t dataSize,
+                        const LocatorList &locators,
+                        const std::chrono::steady_clock::time_point &max_blocking_time_point) -> bool
+    {
+        if (dataSize > std::numeric_limits<uint32_t>::max() - s_channelHeaderSize)
+        {
+            return false;
+        }
+
+        std::vector<octet> buffer = take_buffer();
+        if (buffer.size() < dataSize + s_channelHeaderSize)
+        {
+            buffer.resize(dataSize + s_channelHeaderSize);
+        }
+        write_channel_header(channel_id, buffer.data());
+        memcpy(buffer.data() + s_channelHeaderSize, data, dataSize);
+
+        bool sent = network_sender_->send(buffer.data(), dataSize + s_channelHeaderSize, locators,
+                        max_blocking_time_point);
+        give_back_buffer(std::move(buffer));
+        return sent;
+    };
+}
+
+std::vector<octet> ChannelSenderResource::take_buffer()
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    if (buffers_.empty())
+    {
+        return std::vector<octet>();
+    }
+
+    std::vector<octet> buffer = std::move(buffers_.back());
+    buffers_.pop_back();
+    return buffer;
+}
+
+void ChannelSenderResource::give_back_buffer(
+    std::vector<octet> &&buffer)
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffers_.push_back(std::move(buffer));
+}
+
+} // namespace transport
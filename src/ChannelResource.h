@@ -0,0 +1,150 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ChannelResource.h
+ *
+ */
+
+#ifndef TRANSPORT_CHANNEL_RESOURCE_H_
+#define TRANSPORT_CHANNEL_RESOURCE_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <transport/ReceiverResource.h>
+#include <transport/SenderResource.h>
+
+namespace transport
+{
+
+/**
+ * Header prepended to every datagram of a logical channel:
+ * 2 bytes of magic, 2 reserved bytes and the 4 bytes of the channel id, in network byte order.
+ */
+constexpr uint32_t s_channelHeaderSize = 8;
+//! Marks datagrams carrying a channel header ("TC").
+constexpr uint16_t s_channelHeaderMagic = 0x5443;
+
+class ChannelDemultiplexer;
+
+/**
+ * Receiver of one logical channel. It shares the socket of its locator with the other channels,
+ * and only gets the datagrams carrying its channel id, without the header.
+ * The shared socket is not asked for the metadata of its datagrams, channel callbacks taking it get a
+ * default constructed one.
+ */
+class ChannelReceiverResource : public ReceiverResource
+{
+    friend class ChannelDemultiplexer;
+
+public:
+    ChannelReceiverResource(
+        std::shared_ptr<ReceiverResource> network_receiver,
+        uint32_t channel_id);
+
+    void register_receiver(
+        const ReceiveCallback &callback) override;
+
+    //! Kernel statistics are the ones of the shared socket.
+    ReceiverStatistics statistics() const override;
+
+    uint32_t channel_id() const
+    {
+        return channel_id_;
+    }
+
+private:
+    std::shared_ptr<ReceiverResource> network_receiver_;
+    uint32_t channel_id_;
+};
+
+/**
+ * Dispatch table of the logical channels sharing a socket.
+ * Installed as the callback of the receiver of the socket.
+ */
+class ChannelDemultiplexer
+{
+public:
+    ChannelDemultiplexer() = default;
+
+    //! Returns the receiver of a channel, creating it if needed.
+    std::shared_ptr<ChannelReceiverResource> channel(
+        const std::shared_ptr<ReceiverResource> &network_receiver,
+        uint32_t channel_id);
+
+    //! Routes a datagram of the shared socket to the receiver of its channel.
+    void dispatch(
+        const unsigned char* data,
+        const uint32_t size,
+        const Locator& local_locator,
+        const Locator& remote_locator,
+        const ReceiveMetadata& metadata);
+
+    //! Number of datagrams dropped because of a missing header or an unknown channel.
+    uint32_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, std::weak_ptr<ChannelReceiverResource>> channels_;
+    std::atomic<uint32_t> dropped_{0};
+};
+
+/**
+ * Sender of one logical channel. Prepends the channel header to every message and sends it
+ * through the channel of the underlying transport.
+ * The header and the message are assembled in a buffer taken from the sender and given back after the
+ * send, so that concurrent sends, and sends made again by the network sender before returning, each
+ * get their own buffer without allocating once the pool is warm.
+ */
+class ChannelSenderResource : public SenderResource
+{
+public:
+    ChannelSenderResource(
+        std::shared_ptr<SenderResource> network_sender,
+        uint32_t channel_id);
+
+    virtual Locator locator() const final
+    {
+        return network_sender_->locator();
+    }
+
+    virtual bool set_multicast_loopback(
+        bool enable) override
+    {
+        return network_sender_->set_multicast_loopback(enable);
+    }
+
+private:
+    //! Takes a buffer of the pool, or a new one when all of them are in use.
+    std::vector<octet> take_buffer();
+
+    void give_back_buffer(
+        std::vector<octet> &&buffer);
+
+    std::shared_ptr<SenderResource> network_sender_;
+
+    std::mutex buffers_mutex_;
+    //! Buffers not in use. Holds as many as the sends ever in progress at once.
+    std::vector<std::vector<octet>> buffers_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_CHANNEL_RESOURCE_H_
@@ -0,0 +1,343 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file FlowController.cpp
+ *
+ */
+
+#include <transport/FlowController.h>
+#include <algorithm>
+#include <cstring>
+
+namespace transport
+{
+
+//! Messages of a sender waiting for tokens. Slots keep their buffers between messages.
+//! The first messages may be reserved, taken by the timer and being sent without the lock.
+struct FlowController::Queue
+{
+    struct Message
+    {
+        std::vector<octet> data;
+        uint32_t size = 0;
+        LocatorList locators;
+        //! Failed sends of the message so far.
+        uint32_t attempts = 0;
+    };
+
+    std::shared_ptr<SenderResource> sender;
+    std::vector<Message> messages;
+    size_t head = 0;
+    size_t count = 0;
+    size_t reserved = 0;
+};
+
+/**
+ * Sender whose messages go through a FlowController.
+ */
+class FlowControlledSenderResource : public SenderResource
+{
+public:
+    FlowControlledSenderResource(
+        std::shared_ptr<FlowController> controller,
+        std::shared_ptr<FlowController::Queue> queue)
+    : SenderResource()
+    , controller_(controller)
+    , queue_(queue)
+    {
+        send_lambda_ = [this](
+                            const octet *data,
+                            uint32_t dataSize,
+                            const LocatorList &locators,
+                            const std::chrono::steady_clock::time_point &max_blocking_time_point) -> bool
+        {
+            return controller_->send(*queue_, data, dataSize, locators, max_blocking_time_point, nullptr);
+        };
+    }
+
+    using SenderResource::send;
+
+    virtual bool send(
+        const octet *data,
+        uint32_t dataLength,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback &release) override
+    {
+        return controller_->send(*queue_, data, dataLength, locators, max_blocking_time_point, &release);
+    }
+
+    virtual ~FlowControlledSenderResource()
+    {
+        controller_->remove(queue_.get());
+    }
+
+    virtual Locator locator() const final
+    {
+        return queue_->sender->locator();
+    }
+
+    virtual bool set_multicast_loopback(
+        bool enable) override
+    {
+        return queue_->sender->set_multicast_loopback(enable);
+    }
+
+private:
+    std::shared_ptr<FlowController> controller_;
+    std::shared_ptr<FlowController::Queue> queue_;
+};
+
+FlowController::FlowController(
+    const FlowControllerConfig &config)
+    : config_(config)
+    , bucket_(config.bytes_per_second, config.burst_size, std::chrono::steady_clock::now())
+    , next_(0)
+    , timer_running_(false)
+    , dropped_(0)
+{
+    config_.queue_depth = std::max<uint32_t>(config_.queue_depth, 1);
+}
+
+FlowController::~FlowController()
+{
+    // The timer finds the controller gone and closes itself.
+    if (start_timer_)
+    {
+        start_timer_();
+    }
+}
+
+std::shared_ptr<SenderResource> FlowController::attach(
+    const std::shared_ptr<SenderResource> &sender)
+{
+    auto queue = std::make_shared<Queue>();
+    queue->sender = sender;
+    queue->messages.resize(config_.queue_depth);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queues_.push_back(queue);
+    }
+
+    return std::make_shared<FlowControlledSenderResource>(shared_from_this(), queue);
+}
+
+uint64_t FlowController::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void FlowController::remove(
+    const Queue *queue)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    queues_.erase(std::remove_if(queues_.begin(), queues_.end(), [queue](const std::shared_ptr<Queue> &item)
+    {
+        return item.get() == queue;
+    }), queues_.end());
+    next_ = 0;
+}
+
+void TokenBucket::refill(
+    const std::chrono::steady_clock::time_point &now)
+{
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_refill_).count();
+    if (elapsed >= 1000000000)
+    {
+        tokens_ = std::min<int64_t>(tokens_ + static_cast<int64_t>(bytes_per_second_), burst_size_);
+        last_refill_ = now;
+        return;
+    }
+
+    int64_t tokens = static_cast<int64_t>(bytes_per_second_ * static_cast<uint64_t>(std::max<int64_t>(elapsed, 0)) /
+            1000000000);
+    if (tokens <= 0)
+    {
+        return;
+    }
+
+    tokens_ += tokens;
+    if (tokens_ >= burst_size_)
+    {
+        tokens_ = burst_size_;
+        last_refill_ = now;
+    }
+    else
+    {
+        // Only the time worth the tokens is consumed, so slow rates and short periods do not lose the
+        // fraction of a byte earned since.
+        last_refill_ += std::chrono::nanoseconds(static_cast<uint64_t>(tokens) * 1000000000 / bytes_per_second_);
+    }
+}
+
+bool FlowController::send(
+    Queue &queue,
+    const octet *data,
+    uint32_t size,
+    const LocatorList &locators,
+    const std::chrono::steady_clock::time_point &max_blocking_time_point,
+    const BufferReleaseCallback *release)
+{
+    bool send_now = config_.bytes_per_second == 0;
+    bool start_timer = false;
+
+    if (!send_now)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bucket_.refill(std::chrono::steady_clock::now());
+
+        if (queue.count == 0 && bucket_.take(size))
+        {
+            send_now = true;
+        }
+        else if (queue.count == queue.messages.size())
+        {
+            if (release)
+            {
+                (*release)(data);
+            }
+            return false;
+        }
+        else
+        {
+            Queue::Message &message = queue.messages[(queue.head + queue.count) % queue.messages.size()];
+            if (message.data.size() < size)
+            {
+                message.data.resize(size);
+            }
+            memcpy(message.data.data(), data, size);
+            message.size = size;
+            message.locators = locators;
+            message.attempts = 0;
+            ++queue.count;
+
+            start_timer = !timer_running_;
+            timer_running_ = true;
+        }
+    }
+
+    if (send_now)
+    {
+        return release ?
+               queue.sender->send(data, size, locators, max_blocking_time_point, *release) :
+               queue.sender->send(data, size, locators, max_blocking_time_point);
+    }
+
+    if (release)
+    {
+        (*release)(data);
+    }
+    if (start_timer && start_timer_)
+    {
+        start_timer_();
+    }
+    return true;
+}
+
+bool FlowController::on_timer()
+{
+    struct Pending
+    {
+        std::shared_ptr<Queue> queue;
+        Queue::Message *message;
+        bool sent;
+    };
+    std::vector<Pending> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bucket_.refill(std::chrono::steady_clock::now());
+
+        bool taken = true;
+        while (taken && !queues_.empty())
+        {
+            taken = false;
+
+            for (size_t i = 0; i < queues_.size(); ++i)
+            {
+                const std::shared_ptr<Queue> &queue = queues_[(next_ + i) % queues_.size()];
+                if (queue->reserved == queue->count)
+                {
+                    continue;
+                }
+
+                Queue::Message &message = queue->messages[(queue->head + queue->reserved) %
+                        queue->messages.size()];
+                if (!bucket_.take(message.size))
+                {
+                    continue;
+                }
+
+                // The slot stays in the queue until sent, so that neither a new message nor a direct
+                // send of the same sender gets ahead of it.
+                ++queue->reserved;
+                pending.push_back({queue, &message, false});
+                taken = true;
+            }
+
+            next_ = (next_ + 1) % queues_.size();
+        }
+    }
+
+    // Once a message of a sender fails, the following ones of the round wait as well, so that the
+    // messages of a sender are never reordered.
+    std::vector<const Queue *> failed;
+    for (Pending &item : pending)
+    {
+        if (std::find(failed.begin(), failed.end(), item.queue.get()) != failed.end())
+        {
+            continue;
+        }
+
+        item.sent = item.queue->sender->send(item.message->data.data(), item.message->size,
+                        item.message->locators, std::chrono::steady_clock::now());
+        if (!item.sent && ++item.message->attempts < s_maxSendAttempts)
+        {
+            failed.push_back(item.queue.get());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Pending &item : pending)
+    {
+        Queue &queue = *item.queue;
+        --queue.reserved;
+
+        // The messages sent, or given up on, are the first ones reserved in their queue. The others are
+        // tried again on the next tick.
+        if (!item.sent && item.message->attempts < s_maxSendAttempts)
+        {
+            bucket_.give_back(item.message->size);
+            continue;
+        }
+
+        if (!item.sent)
+        {
+            ++dropped_;
+        }
+        queue.head = (queue.head + 1) % queue.messages.size();
+        --queue.count;
+    }
+
+    timer_running_ = std::any_of(queues_.begin(), queues_.end(), [](const std::shared_ptr<Queue> &queue)
+    {
+        return queue->count > 0;
+    });
+    return timer_running_;
+}
+
+} // namespace transport
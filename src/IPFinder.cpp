@@ -42,6 +42,10 @@
 #if defined(__QNXNTO__)
 #include <net/if_dl.h>
 #endif // if defined(__QNXNTO__)
+#if defined(__linux__)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif // if defined(__linux__)
 #endif // if defined(_WIN32)
 
 #if defined(__FreeBSD__)
@@ -51,6 +55,8 @@
 #include <cstddef>
 #include <cstring>
 #include <algorithm>
+#include <functional>
+#include <unordered_map>
 
 namespace transport
 {
@@ -113,6 +119,7 @@ bool IPFinder::getIPs(
                     info.type = family == AF_INET ? IP4 : IP6;
                     info.name = std::string(buf);
                     info.dev = std::string(aa->AdapterName);
+                    info.index = aa->IfIndex;
 
                     // Currently not supported interfaces that not support multicast.
                     if (aa->Flags & 0x0010)
@@ -145,70 +152,262 @@ bool IPFinder::getIPs(
 
 #else
 
-bool IPFinder::getIPs(
-    std::vector<info_IP> *vec_name,
+//! Fills an info_IP from the binary address of an interface. The numeric name is left to getName.
+static void make_info_ip(
+    int family,
+    const unsigned char *address,
+    const char *dev,
+    uint32_t index,
+    IPFinder::info_IP &info)
+{
+    info.dev = dev;
+    info.index = index;
+    info.locator.port = 0;
+
+    if (family == AF_INET)
+    {
+        info.locator.kind = LOCATOR_KIND_UDPv4;
+        IPLocator::setIPv4(info.locator, address);
+        info.type = IPLocator::isLocal(info.locator) ? IPFinder::IP4_LOCAL : IPFinder::IP4;
+    }
+    else
+    {
+        info.locator.kind = LOCATOR_KIND_UDPv6;
+        IPLocator::setIPv6(info.locator, address);
+        info.type = IPLocator::isLocal(info.locator) ? IPFinder::IP6_LOCAL : IPFinder::IP6;
+    }
+}
+
+static bool is_returned(
+    const IPFinder::info_IP &info,
     bool return_loopback)
 {
-    struct ifaddrs *ifaddr, *ifa;
-    int family, s;
-    char host[NI_MAXHOST];
+    return return_loopback || (info.type != IPFinder::IP4_LOCAL && info.type != IPFinder::IP6_LOCAL);
+}
 
-    // TODO arm64 doesn't seem to support getifaddrs
-    if (getifaddrs(&ifaddr) == -1)
+#if defined(__linux__)
+
+/**
+ * Sends a dump request on a routing netlink socket, and hands every message of the answer to handler.
+ */
+static bool netlink_dump(
+    int fd,
+    uint16_t type,
+    uint32_t sequence,
+    const std::function<void(nlmsghdr *)> &handler)
+{
+    struct
+    {
+        nlmsghdr header;
+        rtgenmsg message;
+    } request = {};
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(rtgenmsg));
+    request.header.nlmsg_type = type;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = sequence;
+    request.message.rtgen_family = AF_UNSPEC;
+
+    sockaddr_nl kernel = {};
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(fd, &request, request.header.nlmsg_len, 0, reinterpret_cast<const sockaddr *>(&kernel),
+            sizeof(kernel)) < 0)
     {
-        perror("getifaddrs");
         return false;
     }
 
-    for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next)
+    // The kernel does not build dump messages larger than 32 KB.
+    alignas(nlmsghdr) char buffer[32768];
+    for (;;)
     {
-        if (ifa->ifa_addr == NULL || (ifa->ifa_flags & IFF_RUNNING) == 0)
+        iovec data = {buffer, sizeof(buffer)};
+        sockaddr_nl sender = {};
+        msghdr message = {};
+        message.msg_name = &sender;
+        message.msg_namelen = sizeof(sender);
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+
+        ssize_t received = recvmsg(fd, &message, 0);
+        if (received < 0 && errno == EINTR)
         {
             continue;
         }
 
-        family = ifa->ifa_addr->sa_family;
+        // A truncated answer lacks some entries, the caller falls back to getifaddrs.
+        if (received <= 0 || (message.msg_flags & MSG_TRUNC))
+        {
+            return false;
+        }
 
-        if (family == AF_INET)
+        int length = static_cast<int>(received);
+        for (nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer); NLMSG_OK(header, length);
+                header = NLMSG_NEXT(header, length))
         {
-            s = getnameinfo(ifa->ifa_addr, sizeof(struct sockaddr_in),
-                            host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST);
-            if (s != 0)
+            if (header->nlmsg_seq != sequence)
             {
-                // LOG_WARN(UTILS, "getnameinfo() failed: " << gai_strerror(s));
                 continue;
             }
-            info_IP info;
-            info.type = IP4;
-            info.name = std::string(host);
-            info.dev = std::string(ifa->ifa_name);
-            parseIP4(info);
+            if (header->nlmsg_type == NLMSG_DONE)
+            {
+                return true;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR)
+            {
+                return false;
+            }
+            handler(header);
+        }
+    }
+}
+
+/**
+ * getIPs through a routing netlink socket: the links give the names and states of the interfaces,
+ * the addresses are read in binary form, without any conversion to text and back.
+ */
+static bool get_ips_from_netlink(
+    std::vector<IPFinder::info_IP> *vec_name,
+    bool return_loopback)
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct Link
+    {
+        unsigned int flags = 0;
+        std::string name;
+    };
+    std::unordered_map<int, Link> links;
+
+    bool dumped = netlink_dump(fd, RTM_GETLINK, 1, [&links](nlmsghdr *header)
+    {
+        if (header->nlmsg_type != RTM_NEWLINK)
+        {
+            return;
+        }
+
+        ifinfomsg *link = static_cast<ifinfomsg *>(NLMSG_DATA(header));
+        Link &entry = links[link->ifi_index];
+        entry.flags = link->ifi_flags;
 
-            if (return_loopback || info.type != IP4_LOCAL)
+        int length = static_cast<int>(IFLA_PAYLOAD(header));
+        for (rtattr *attribute = IFLA_RTA(link); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length))
+        {
+            if (attribute->rta_type == IFLA_IFNAME)
             {
-                vec_name->push_back(info);
+                const char *name = static_cast<const char *>(RTA_DATA(attribute));
+                entry.name.assign(name, strnlen(name, RTA_PAYLOAD(attribute)));
             }
         }
-        else if (family == AF_INET6)
+    });
+
+    std::vector<IPFinder::info_IP> ips;
+    dumped = dumped && netlink_dump(fd, RTM_GETADDR, 2, [&links, &ips, return_loopback](nlmsghdr *header)
+    {
+        if (header->nlmsg_type != RTM_NEWADDR)
         {
-            s = getnameinfo(ifa->ifa_addr, sizeof(struct sockaddr_in6),
-                            host, NI_MAXHOST, NULL, 0, NI_NUMERICHOST);
-            if (s != 0)
+            return;
+        }
+
+        ifaddrmsg *address = static_cast<ifaddrmsg *>(NLMSG_DATA(header));
+        size_t address_length = address->ifa_family == AF_INET ? 4 : 16;
+        auto link = links.find(static_cast<int>(address->ifa_index));
+        if ((address->ifa_family != AF_INET && address->ifa_family != AF_INET6) || link == links.end() ||
+                (link->second.flags & IFF_RUNNING) == 0)
+        {
+            return;
+        }
+
+        // IFA_ADDRESS is the remote end of point to point IPv4 links, IFA_LOCAL the address of this host.
+        const unsigned char *local = nullptr;
+        const unsigned char *any = nullptr;
+        int length = static_cast<int>(IFA_PAYLOAD(header));
+        for (rtattr *attribute = IFA_RTA(address); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length))
+        {
+            if (RTA_PAYLOAD(attribute) < address_length)
             {
-                // LOG_WARN(UTILS, "getnameinfo() failed: " << gai_strerror(s));
                 continue;
             }
-            info_IP info;
-            info.type = IP6;
-            info.name = std::string(host);
-            info.dev = std::string(ifa->ifa_name);
-            if (parseIP6(info))
+            if (attribute->rta_type == IFA_LOCAL)
             {
-                if (return_loopback || info.type != IP6_LOCAL)
-                {
-                    vec_name->push_back(info);
-                }
+                local = static_cast<const unsigned char *>(RTA_DATA(attribute));
             }
+            else if (attribute->rta_type == IFA_ADDRESS)
+            {
+                any = static_cast<const unsigned char *>(RTA_DATA(attribute));
+            }
+        }
+
+        if (!local && !any)
+        {
+            return;
+        }
+
+        IPFinder::info_IP info;
+        make_info_ip(address->ifa_family, local ? local : any, link->second.name.c_str(), address->ifa_index, info);
+        if (is_returned(info, return_loopback))
+        {
+            ips.push_back(info);
+        }
+    });
+
+    close(fd);
+
+    if (!dumped)
+    {
+        return false;
+    }
+
+    vec_name->insert(vec_name->end(), ips.begin(), ips.end());
+    return true;
+}
+
+#endif // if defined(__linux__)
+
+static bool get_ips_from_ifaddrs(
+    std::vector<IPFinder::info_IP> *vec_name,
+    bool return_loopback)
+{
+    struct ifaddrs *ifaddr, *ifa;
+
+    // TODO arm64 doesn't seem to support getifaddrs
+    if (getifaddrs(&ifaddr) == -1)
+    {
+        perror("getifaddrs");
+        return false;
+    }
+
+    for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next)
+    {
+        if (ifa->ifa_addr == NULL || (ifa->ifa_flags & IFF_RUNNING) == 0)
+        {
+            continue;
+        }
+
+        const unsigned char *address;
+        int family = ifa->ifa_addr->sa_family;
+        if (family == AF_INET)
+        {
+            address = reinterpret_cast<const unsigned char *>(
+                &reinterpret_cast<const sockaddr_in *>(ifa->ifa_addr)->sin_addr);
+        }
+        else if (family == AF_INET6)
+        {
+            address = reinterpret_cast<const unsigned char *>(
+                &reinterpret_cast<const sockaddr_in6 *>(ifa->ifa_addr)->sin6_addr);
+        }
+        else
+        {
+            continue;
+        }
+
+        IPFinder::info_IP info;
+        make_info_ip(family, address, ifa->ifa_name, 0, info);
+        if (is_returned(info, return_loopback))
+        {
+            vec_name->push_back(info);
         }
     }
 
@@ -216,6 +415,20 @@ bool IPFinder::getIPs(
     return true;
 }
 
+bool IPFinder::getIPs(
+    std::vector<info_IP> *vec_name,
+    bool return_loopback)
+{
+#if defined(__linux__)
+    if (get_ips_from_netlink(vec_name, return_loopback))
+    {
+        return true;
+    }
+#endif // if defined(__linux__)
+
+    return get_ips_from_ifaddrs(vec_name, return_loopback);
+}
+
 #endif // if defined(_WIN32)
 
 #if defined(_WIN32)
@@ -408,6 +621,146 @@ bool IPFinder::getAllIPAddress(
     return false;
 }
 
+bool IPFinder::getLocalAddresses(
+    LocatorList *locators)
+{
+    std::vector<info_IP> ip_names;
+    if (IPFinder::getIPs(&ip_names, true))
+    {
+        locators->clear();
+        for (auto it = ip_names.begin();
+                it != ip_names.end(); ++it)
+        {
+            locators->push_back(it->locator);
+        }
+        return true;
+    }
+    return false;
+}
+
+std::string IPFinder::getName(
+    const info_IP &info)
+{
+    if (!info.name.empty())
+    {
+        return info.name;
+    }
+
+    bool is_ipv6 = info.type == IP6 || info.type == IP6_LOCAL;
+    char buffer[INET6_ADDRSTRLEN];
+    if (inet_ntop(is_ipv6 ? AF_INET6 : AF_INET, is_ipv6 ? info.locator.address : info.locator.address + 12,
+            buffer, sizeof(buffer)) == nullptr)
+    {
+        return std::string();
+    }
+
+    std::string name(buffer);
+    if (is_ipv6 && info.locator.address[0] == 0xFE && (info.locator.address[1] & 0xC0) == 0x80)
+    {
+        name += "%" + info.dev;
+    }
+    return name;
+}
+
+bool IPFinder::matchesInterface(
+    const info_IP &info,
+    const std::string &filter)
+{
+    if (filter == info.dev)
+    {
+        return true;
+    }
+
+    // Addresses are compared in binary form, as blocks with a full length prefix. Scopes are ignored.
+    size_t slash = filter.find('/');
+    std::string network_name = filter.substr(0, std::min(slash, filter.find('%')));
+
+    bool is_ipv6 = info.type == IP6 || info.type == IP6_LOCAL;
+    unsigned char network[16];
+    if (inet_pton(is_ipv6 ? AF_INET6 : AF_INET, network_name.c_str(), network) != 1)
+    {
+        return false;
+    }
+
+    int max_length = is_ipv6 ? 128 : 32;
+    int length = max_length;
+    if (slash != std::string::npos)
+    {
+        // A malformed prefix length must not read as /0, which would match every address.
+        std::string prefix = filter.substr(slash + 1);
+        if (prefix.empty() || prefix.size() > 3 ||
+                prefix.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+        length = atoi(prefix.c_str());
+    }
+    if (length > max_length)
+    {
+        return false;
+    }
+
+    // IPv4 addresses are stored in the last four bytes of the locator.
+    const unsigned char *host = is_ipv6 ? info.locator.address : info.locator.address + 12;
+    int full_bytes = length / 8;
+    if (memcmp(host, network, static_cast<size_t>(full_bytes)) != 0)
+    {
+        return false;
+    }
+
+    int remaining_bits = length % 8;
+    if (remaining_bits == 0)
+    {
+        return true;
+    }
+
+    unsigned char mask = static_cast<unsigned char>(0xFF << (8 - remaining_bits));
+    return (host[full_bytes] & mask) == (network[full_bytes] & mask);
+}
+
+bool IPFinder::isInterfaceAllowed(
+    const info_IP &info,
+    const std::vector<std::string> &whitelist,
+    const std::vector<std::string> &blacklist)
+{
+    auto matches = [&info](const std::string &filter)
+    {
+        return matchesInterface(info, filter);
+    };
+
+    return (whitelist.empty() || std::any_of(whitelist.begin(), whitelist.end(), matches)) &&
+           std::none_of(blacklist.begin(), blacklist.end(), matches);
+}
+
+uint32_t IPFinder::getInterfaceIndex(
+    const std::string &interface)
+{
+#if defined(_WIN32)
+    (void)interface;
+    return 0;
+#else
+    uint32_t index = if_nametoindex(interface.c_str());
+    if (index != 0)
+    {
+        return index;
+    }
+
+    std::vector<info_IP> ip_names;
+    if (IPFinder::getIPs(&ip_names, true))
+    {
+        for (const info_IP &info : ip_names)
+        {
+            // IPv6 names carry the scope of the address after a '%'.
+            if (info.name == interface || info.name.substr(0, info.name.find('%')) == interface)
+            {
+                return if_nametoindex(info.dev.c_str());
+            }
+        }
+    }
+    return 0;
+#endif // if defined(_WIN32)
+}
+
 bool IPFinder::getIP6Address(
     LocatorList *locators)
 {
@@ -49,8 +49,11 @@ public:
     typedef struct info_IP
     {
         IPTYPE type;
+        //! Numeric address, empty until formatted (see getName).
         std::string name;
         std::string dev;
+        //! Index of the interface, 0 when unknown.
+        uint32_t index = 0;
         Locator locator;
     } info_IP;
 
@@ -72,10 +75,24 @@ public:
     IPFinder();
     virtual ~IPFinder();
 
+    /**
+     * Get the addresses of the running interfaces. Locators are built from the binary addresses, their
+     * numeric names are only formatted on demand by getName. On Linux the addresses are dumped from a
+     * routing netlink socket (RTM_GETLINK, RTM_GETADDR), getifaddrs is used when it is not available.
+     * @param[out] vec_name List the addresses are appended to.
+     * @param return_loopback Include the loopback addresses.
+     */
     static bool getIPs(
         std::vector<info_IP> *vec_name,
         bool return_loopback = false);
 
+    /**
+     * Returns the numeric address of an info_IP, formatting it when getIPs left it empty.
+     * Link-local IPv6 addresses carry the interface as scope, as getnameinfo does.
+     */
+    static std::string getName(
+        const info_IP &info);
+
     /**
      * Get the IP4Adresses in all interfaces.
      * @param[out] locators List of locators to be populated with the IP4 addresses.
@@ -94,6 +111,12 @@ public:
      */
     static bool getAllIPAddress(
         LocatorList *locators);
+    /**
+     * Get the addresses of this host, loopback included, used to decide whether a peer is local.
+     * @param[out] locators List of locators to be populated with the addresses.
+     */
+    static bool getLocalAddresses(
+        LocatorList *locators);
     /**
      * Parses an IP4 string, populating a info_IP with its value.
      * @param[out] info info_IP to populate.
@@ -107,6 +130,30 @@ public:
     static bool parseIP6(
         info_IP &info);
 
+    /**
+     * Reports whether an address of an interface matches a filter, which is either the name of the
+     * interface, the address itself or a CIDR block such as 10.0.0.0/8 or fd00::/8.
+     */
+    static bool matchesInterface(
+        const info_IP &info,
+        const std::string &filter);
+
+    /**
+     * Applies an interface whitelist and blacklist, made of matchesInterface filters, to an address.
+     * An empty whitelist allows every address, the blacklist wins over the whitelist.
+     */
+    static bool isInterfaceAllowed(
+        const info_IP &info,
+        const std::vector<std::string> &whitelist,
+        const std::vector<std::string> &blacklist);
+
+    /**
+     * Returns the index of an interface given its name or one of its addresses.
+     * @return 0 when no interface matches.
+     */
+    static uint32_t getInterfaceIndex(
+        const std::string &interface);
+
     static std::string getIPv4Address(
         const std::string &name);
     static std::string getIPv6Address(
@@ -21,6 +21,13 @@
 #include <regex>
 #include <set>
 #include "IPFinder.h"
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif // if defined(_WIN32)
 
 namespace transport
 {
@@ -57,6 +64,61 @@ void IPLocator::createLocator(
     }
 }
 
+bool IPLocator::createLocator(
+    int32_t kindin,
+    const struct sockaddr *address,
+    Locator &locator)
+{
+    locator.kind = kindin;
+    LOCATOR_ADDRESS_INVALID(locator.address);
+
+    if (address->sa_family == AF_INET &&
+        (kindin == LOCATOR_KIND_UDPv4 || kindin == LOCATOR_KIND_TCPv4))
+    {
+        const sockaddr_in *addr4 = reinterpret_cast<const sockaddr_in *>(address);
+        locator.port = ntohs(addr4->sin_port);
+        memcpy(&locator.address[12], &addr4->sin_addr, 4);
+        return true;
+    }
+    else if (address->sa_family == AF_INET6 &&
+        (kindin == LOCATOR_KIND_UDPv6 || kindin == LOCATOR_KIND_TCPv6))
+    {
+        const sockaddr_in6 *addr6 = reinterpret_cast<const sockaddr_in6 *>(address);
+        locator.port = ntohs(addr6->sin6_port);
+        memcpy(locator.address, &addr6->sin6_addr, 16);
+        return true;
+    }
+
+    locator.port = 0;
+    return false;
+}
+
+uint32_t IPLocator::toSockaddr(
+    const Locator &locator,
+    struct sockaddr_storage &address)
+{
+    memset(&address, 0, sizeof(address));
+
+    if (locator.kind == LOCATOR_KIND_UDPv4 || locator.kind == LOCATOR_KIND_TCPv4)
+    {
+        sockaddr_in *addr4 = reinterpret_cast<sockaddr_in *>(&address);
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = htons(static_cast<uint16_t>(locator.port));
+        memcpy(&addr4->sin_addr, &locator.address[12], 4);
+        return sizeof(sockaddr_in);
+    }
+    else if (locator.kind == LOCATOR_KIND_UDPv6 || locator.kind == LOCATOR_KIND_TCPv6)
+    {
+        sockaddr_in6 *addr6 = reinterpret_cast<sockaddr_in6 *>(&address);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(static_cast<uint16_t>(locator.port));
+        memcpy(&addr6->sin6_addr, locator.address, 16);
+        return sizeof(sockaddr_in6);
+    }
+
+    return 0;
+}
+
 // IPv4
 bool IPLocator::setIPv4(
     Locator &locator,
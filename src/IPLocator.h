@@ -24,6 +24,9 @@
 #include <set>
 #include <transport/type.h>
 
+struct sockaddr;
+struct sockaddr_storage;
+
 namespace transport
 {
 
@@ -47,6 +50,28 @@ public:
         uint32_t portin,
         Locator &locator);
 
+    /**
+     * Fills locator from a binary socket address, without going through its string representation.
+     * @param kindin Kind of the locator.
+     * @param address Socket address (AF_INET or AF_INET6).
+     * @param locator Locator to be filled.
+     * @return false when the address family does not match the kind.
+     */
+    static bool createLocator(
+        int32_t kindin,
+        const struct sockaddr *address,
+        Locator &locator);
+
+    /**
+     * Fills a binary socket address from the IP address and port of a locator.
+     * @param locator Locator to convert.
+     * @param address Socket address to be filled.
+     * @return Length of the filled socket address, 0 when the locator kind is not IP based.
+     */
+    static uint32_t toSockaddr(
+        const Locator &locator,
+        struct sockaddr_storage &address);
+
     //! Sets locator's IPv4.
     static bool setIPv4(
         Locator &locator,
@@ -0,0 +1,132 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file IntraProcessMailbox.cpp
+ *
+ */
+
+#include "IntraProcessMailbox.h"
+#include <uvw.hpp>
+
+namespace transport
+{
+
+IntraProcessMailbox::IntraProcessMailbox(
+    std::shared_ptr<uvw::loop> loop,
+    const Handler &handler,
+    uint32_t capacity)
+    : handler_(handler)
+    , head_(0)
+    , tail_(0)
+    , closed_(false)
+{
+    uint32_t slots = 1;
+    while (slots < capacity)
+    {
+        slots <<= 1;
+    }
+    slots_.resize(slots);
+    mask_ = slots - 1;
+
+    wakeup_ = loop->resource<uvw::async_handle>();
+    wakeup_->on<uvw::async_event>([this](const uvw::async_event &, uvw::async_handle &)
+    {
+        drain();
+    });
+
+    // The mailbox alone must not keep the loop running.
+    wakeup_->unreference();
+}
+
+bool IntraProcessMailbox::post(
+    const std::shared_ptr<ReceiverResource> &receiver,
+    const octet *data,
+    uint32_t size,
+    const Locator &source)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_)
+    {
+        return false;
+    }
+
+    if (tail_ - head_ > mask_)
+    {
+        receiver->mailbox_drops_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // The buffer of the slot is reused, it only grows.
+    Message &message = slots_[tail_ & mask_];
+    message.receiver = receiver;
+    message.data.assign(data, data + size);
+    message.source = source;
+
+    // Wake-ups are coalesced by the loop, the first message of a batch is enough.
+    if (tail_++ == head_)
+    {
+        wakeup_->send();
+    }
+    return true;
+}
+
+void IntraProcessMailbox::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        for (; head_ != tail_; ++head_)
+        {
+            slots_[head_ & mask_].receiver.reset();
+        }
+    }
+
+    wakeup_->close();
+}
+
+void IntraProcessMailbox::drain()
+{
+    uint32_t pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending = tail_ - head_;
+    }
+
+    // Receivers are called without the lock, their callbacks may send to this process again. Producers
+    // leave the slot alone until head_ moves past it.
+    for (uint32_t i = 0; i < pending; ++i)
+    {
+        Message &message = slots_[head_ & mask_];
+        handler_(*message.receiver, message.data.data(), static_cast<uint32_t>(message.data.size()),
+            message.source);
+        message.receiver.reset();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_)
+        {
+            return;
+        }
+        ++head_;
+    }
+
+    // Messages posted meanwhile found the mailbox not empty and did not wake the loop up.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (head_ != tail_ && !closed_)
+    {
+        wakeup_->send();
+    }
+}
+
+} // namespace transport
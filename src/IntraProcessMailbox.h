@@ -0,0 +1,118 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file IntraProcessMailbox.h
+ *
+ */
+
+#ifndef TRANSPORT_INTRA_PROCESS_MAILBOX_H_
+#define TRANSPORT_INTRA_PROCESS_MAILBOX_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <transport/type.h>
+#include <transport/ReceiverResource.h>
+
+namespace uvw
+{
+    class loop;
+    class async_handle;
+}
+
+namespace transport
+{
+
+/**
+ * Messages sent by this process to the receivers of one loop, handed over to the thread of that loop.
+ * Any thread may post, the loop thread delivers, so receivers keep a single producing thread and their
+ * callbacks never run concurrently with those of the loop.
+ * Messages wait in a bounded ring whose slots keep their buffers, so no allocation happens once every
+ * slot has seen a message of the maximum size. A message posted while the ring is full is dropped, as
+ * a full socket would, and accounted in ReceiverStatistics::dispatch_drops of its receiver.
+ */
+class IntraProcessMailbox
+{
+public:
+    //! Hands a posted message to its receiver, on the thread of the loop.
+    using Handler = std::function<void(
+        ReceiverResource &receiver,
+        const octet *data,
+        uint32_t size,
+        const Locator &source)>;
+
+    //! Messages a mailbox holds by default.
+    static constexpr uint32_t s_defaultCapacity = 256;
+
+    /**
+     * Must be called from the thread of the loop.
+     * @param loop Loop the messages are delivered on.
+     * @param handler Called with every posted message.
+     * @param capacity Messages waiting for the loop at most, rounded up to a power of two.
+     */
+    IntraProcessMailbox(
+        std::shared_ptr<uvw::loop> loop,
+        const Handler &handler,
+        uint32_t capacity = s_defaultCapacity);
+
+    /**
+     * Copies a message for the receiver and wakes up the loop.
+     * The message is dropped when the mailbox is full, which still counts as handled.
+     * @return false once the mailbox is closed.
+     */
+    bool post(
+        const std::shared_ptr<ReceiverResource> &receiver,
+        const octet *data,
+        uint32_t size,
+        const Locator &source);
+
+    //! Drops the pending messages and stops the delivery. Must be called from the thread of the loop.
+    void close();
+
+private:
+    struct Message
+    {
+        std::shared_ptr<ReceiverResource> receiver;
+        std::vector<octet> data;
+        Locator source;
+    };
+
+    IntraProcessMailbox(
+        const IntraProcessMailbox &) = delete;
+    IntraProcessMailbox &operator=(
+        const IntraProcessMailbox &) = delete;
+
+    //! Delivers the messages pending when called, in posting order.
+    void drain();
+
+    Handler handler_;
+
+    //! Guards the indexes and the slots not being delivered.
+    std::mutex mutex_;
+    std::vector<Message> slots_;
+    uint32_t mask_;
+    //! Next slot to be delivered. The loop thread delivers it without the lock, it is only released after.
+    uint32_t head_;
+    //! Next slot to be posted.
+    uint32_t tail_;
+    bool closed_;
+
+    std::shared_ptr<uvw::async_handle> wakeup_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_INTRA_PROCESS_MAILBOX_H_
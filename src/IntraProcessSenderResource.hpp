@@ -0,0 +1,152 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_INTRA_PROCESS_SENDER_RESOURCE_HPP__
+#define TRANSPORT_INTRA_PROCESS_SENDER_RESOURCE_HPP__
+
+#include <functional>
+#include <memory>
+#include <transport/type.h>
+#include <transport/SenderResource.h>
+
+namespace transport
+{
+
+/**
+ * Delivers a message to a receiver of the same process listening on the destination.
+ * @return false when there is no such receiver.
+ */
+using IntraProcessDelivery = std::function<bool(
+    const octet *,
+    uint32_t,
+    const Locator &destination,
+    const Locator &source)>;
+
+/**
+ * Sender wrapping the channel built by a transport. Unicast destinations listened to by a receiver
+ * of the same TransportFactory get a copy of the message handed to the loop of that receiver,
+ * without any syscall. Every other destination goes through the wrapped channel.
+ */
+class IntraProcessSenderResource : public SenderResource
+{
+public:
+    IntraProcessSenderResource(
+        std::shared_ptr<SenderResource> network_sender,
+        const IntraProcessDelivery &deliver_local)
+    : SenderResource()
+    , network_sender_(network_sender)
+    , deliver_local_(deliver_local)
+    {
+        send_lambda_ = [this](
+                            const octet *data,
+                            uint32_t dataSize,
+                            const LocatorList &locators,
+                            const std::chrono::steady_clock::time_point &max_blocking_time_point) -> bool
+        {
+            return send_to(data, dataSize, locators, max_blocking_time_point, nullptr);
+        };
+    }
+
+    using SenderResource::send;
+
+    virtual bool send(
+        const octet *data,
+        uint32_t dataLength,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback &release) override
+    {
+        return send_to(data, dataLength, locators, max_blocking_time_point, &release);
+    }
+
+    virtual Locator locator() const final
+    {
+        return network_sender_->locator();
+    }
+
+    virtual bool set_multicast_loopback(
+        bool enable) override
+    {
+        return network_sender_->set_multicast_loopback(enable);
+    }
+
+    virtual ~IntraProcessSenderResource()
+    {
+    }
+
+private:
+    IntraProcessSenderResource() = delete;
+
+    IntraProcessSenderResource(
+        const SenderResource &) = delete;
+
+    IntraProcessSenderResource &operator=(
+        const SenderResource &) = delete;
+
+    //! Delivers in place and hands the remaining destinations to the network, releasing the buffer
+    //! right away when the network is not used.
+    bool send_to(
+        const octet *data,
+        uint32_t dataSize,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback *release)
+    {
+        Locator source = network_sender_->locator();
+
+        // The list handed to the network is only rebuilt when some destinations were delivered locally.
+        bool delivered = false;
+        LocatorList network_locators;
+
+        for (auto it = locators.begin(); it != locators.end(); ++it)
+        {
+            if (deliver_local_(data, dataSize, *it, source))
+            {
+                if (!delivered)
+                {
+                    for (auto previous = locators.begin(); previous != it; ++previous)
+                    {
+                        network_locators.push_back(*previous);
+                    }
+                    delivered = true;
+                }
+            }
+            else if (delivered)
+            {
+                network_locators.push_back(*it);
+            }
+        }
+
+        const LocatorList &remaining = delivered ? network_locators : locators;
+        if (remaining.empty())
+        {
+            if (release)
+            {
+                (*release)(data);
+            }
+            return true;
+        }
+
+        return release ?
+               network_sender_->send(data, dataSize, remaining, max_blocking_time_point, *release) :
+               network_sender_->send(data, dataSize, remaining, max_blocking_time_point);
+    }
+
+    std::shared_ptr<SenderResource> network_sender_;
+    IntraProcessDelivery deliver_local_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_INTRA_PROCESS_SENDER_RESOURCE_HPP__
@@ -0,0 +1,203 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file LoopPool.cpp
+ *
+ */
+
+#include "LoopPool.h"
+#include <algorithm>
+#include <future>
+#include <uvw.hpp>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif // if defined(__linux__)
+
+namespace transport
+{
+
+LoopPool::LoopPool(
+    uint32_t size,
+    bool pin_threads)
+    : next_(0)
+{
+    size = std::max<uint32_t>(size, 1);
+    uint32_t cpus = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->loop = uvw::loop::create();
+
+        // The async handle keeps the loop alive while it has no channel, and wakes it up to run tasks.
+        Worker *raw_worker = worker.get();
+        worker->wakeup = worker->loop->resource<uvw::async_handle>();
+        worker->wakeup->on<uvw::async_event>([raw_worker](const uvw::async_event &, uvw::async_handle &)
+        {
+            std::vector<std::function<void()>> tasks;
+            {
+                std::lock_guard<std::mutex> lock(raw_worker->mutex);
+                tasks.swap(raw_worker->tasks);
+            }
+
+            for (auto &task : tasks)
+            {
+                task();
+            }
+        });
+
+        worker->thread = std::thread([raw_worker]()
+        {
+            raw_worker->loop->run();
+        });
+
+#if defined(__linux__)
+        if (pin_threads)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(i % cpus, &cpu_set);
+            pthread_setaffinity_np(worker->thread.native_handle(), sizeof(cpu_set), &cpu_set);
+        }
+#else
+        (void)pin_threads;
+        (void)cpus;
+#endif // if defined(__linux__)
+
+        workers_.push_back(std::move(worker));
+    }
+}
+
+LoopPool::~LoopPool()
+{
+    for (auto &worker : workers_)
+    {
+        Worker *raw_worker = worker.get();
+        post(*worker, [raw_worker]()
+        {
+            raw_worker->wakeup->close();
+            raw_worker->loop->stop();
+        });
+    }
+
+    for (auto &worker : workers_)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+std::shared_ptr<uvw::loop> LoopPool::loop(
+    size_t index) const
+{
+    return workers_.at(index)->loop;
+}
+
+size_t LoopPool::select(
+    LoopPolicy policy,
+    int32_t affinity)
+{
+    size_t index = 0;
+
+    switch (policy)
+    {
+    case LoopPolicy::AFFINITY:
+    {
+        if (affinity >= 0)
+        {
+            index = static_cast<size_t>(affinity) % workers_.size();
+            break;
+        }
+        index = next_.fetch_add(1) % workers_.size();
+        break;
+    }
+    case LoopPolicy::LEAST_LOADED:
+    {
+        for (size_t i = 1; i < workers_.size(); ++i)
+        {
+            if (workers_[i]->channels.load() < workers_[index]->channels.load())
+            {
+                index = i;
+            }
+        }
+        break;
+    }
+    case LoopPolicy::ROUND_ROBIN:
+    default:
+    {
+        index = next_.fetch_add(1) % workers_.size();
+        break;
+    }
+    }
+
+    return index;
+}
+
+void LoopPool::acquire(
+    size_t index)
+{
+    workers_.at(index)->channels.fetch_add(1);
+}
+
+void LoopPool::release(
+    size_t index)
+{
+    workers_.at(index)->channels.fetch_sub(1);
+}
+
+void LoopPool::run(
+    size_t index,
+    const std::function<void()> &task)
+{
+    Worker &worker = *workers_.at(index);
+
+    if (std::this_thread::get_id() == worker.thread.get_id())
+    {
+        task();
+        return;
+    }
+
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    post(worker, [&task, &done]()
+    {
+        try
+        {
+            task();
+            done.set_value();
+        }
+        catch (...)
+        {
+            done.set_exception(std::current_exception());
+        }
+    });
+    finished.get();
+}
+
+void LoopPool::post(
+    Worker &worker,
+    std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    worker.wakeup->send();
+}
+
+} // namespace transport
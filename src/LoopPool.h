@@ -0,0 +1,119 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file LoopPool.h
+ *
+ */
+
+#ifndef TRANSPORT_LOOP_POOL_H_
+#define TRANSPORT_LOOP_POOL_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <transport/TransportFactory.h>
+
+namespace uvw
+{
+class loop;
+class async_handle;
+}
+
+namespace transport
+{
+
+/**
+ * Set of event loops, each one owned and run by its own thread.
+ * Handles must only be created and used from the thread of the loop they belong to,
+ * run() is the way for other threads to execute code there.
+ * @ingroup NETWORK_MODULE
+ */
+class LoopPool
+{
+public:
+    /**
+     * Creates and starts the loops.
+     * @param size Number of loops (and threads).
+     * @param pin_threads Pin the thread of loop i to CPU i (modulo the number of CPUs).
+     */
+    LoopPool(
+        uint32_t size,
+        bool pin_threads);
+
+    //! Stops every loop and joins its thread.
+    ~LoopPool();
+
+    size_t size() const
+    {
+        return workers_.size();
+    }
+
+    std::shared_ptr<uvw::loop> loop(
+        size_t index) const;
+
+    /**
+     * Chooses the loop a new channel is assigned to. The channel is only accounted on it once opened,
+     * see acquire.
+     * @param policy Selection policy.
+     * @param affinity Requested loop for LoopPolicy::AFFINITY, ignored by the other policies.
+     * @return Index of the selected loop.
+     */
+    size_t select(
+        LoopPolicy policy,
+        int32_t affinity);
+
+    //! Accounts a channel opened on a loop, for LoopPolicy::LEAST_LOADED.
+    void acquire(
+        size_t index);
+
+    //! Accounts a channel of a loop being closed.
+    void release(
+        size_t index);
+
+    /**
+     * Runs a task on the thread of the given loop and waits for it to finish.
+     * Executes it in place when called from that thread. Exceptions of the task are rethrown to the caller.
+     */
+    void run(
+        size_t index,
+        const std::function<void()> &task);
+
+private:
+    struct Worker
+    {
+        std::shared_ptr<uvw::loop> loop;
+        std::shared_ptr<uvw::async_handle> wakeup;
+        std::mutex mutex;
+        std::vector<std::function<void()>> tasks;
+        std::atomic<uint32_t> channels{0};
+        std::thread thread;
+    };
+
+    //! Queues a task on a loop without waiting for it.
+    void post(
+        Worker &worker,
+        std::function<void()> task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::atomic<uint32_t> next_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_LOOP_POOL_H_
@@ -0,0 +1,238 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ReceiveDispatcher.cpp
+ *
+ */
+
+#include <transport/ReceiveDispatcher.h>
+#include <algorithm>
+#include "ReceiveQueue.h"
+
+namespace transport
+{
+
+//! Messages handed from one queue before the worker moves to the next one.
+constexpr uint32_t s_maxMessagesPerDrain = 32;
+
+ReceiveQueue::ReceiveQueue(
+    uint32_t capacity,
+    const MetadataReceiveCallback &handler,
+    ReceiveWorker *worker)
+    : mask_(0)
+    , handler_(handler)
+    , worker_(worker)
+    , head_(0)
+    , tail_(0)
+    , dropped_(0)
+    , detached_(false)
+{
+    uint32_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+}
+
+bool ReceiveQueue::push(
+    const unsigned char *data,
+    uint32_t size,
+    const Locator &local_locator,
+    const Locator &remote_locator,
+    const ReceiveMetadata &metadata)
+{
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Slot &slot = slots_[tail & mask_];
+    slot.data.assign(data, data + size);
+    slot.local_locator = local_locator;
+    slot.remote_locator = remote_locator;
+    slot.metadata = metadata;
+    tail_.store(tail + 1, std::memory_order_release);
+
+    worker_->notify();
+    return true;
+}
+
+bool ReceiveQueue::drain(
+    uint32_t max_messages)
+{
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    uint32_t count = std::min(tail - head, max_messages);
+
+    for (uint32_t i = 0; i < count && !detached(); ++i)
+    {
+        Slot &slot = slots_[(head + i) & mask_];
+        handler_(slot.data.data(), static_cast<uint32_t>(slot.data.size()),
+                slot.local_locator, slot.remote_locator, slot.metadata);
+        head_.store(head + i + 1, std::memory_order_release);
+    }
+
+    return count > 0;
+}
+
+ReceiveWorker::ReceiveWorker()
+    : wakeups_(0)
+    , sleeping_(false)
+    , running_(true)
+{
+    thread_ = std::thread(&ReceiveWorker::run, this);
+}
+
+ReceiveWorker::~ReceiveWorker()
+{
+    running_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(wakeup_mutex_);
+        ++wakeups_;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+void ReceiveWorker::add(
+    const std::shared_ptr<ReceiveQueue> &queue)
+{
+    std::lock_guard<std::mutex> lock(queues_mutex_);
+    queues_.push_back(queue);
+}
+
+void ReceiveWorker::remove(
+    const std::shared_ptr<ReceiveQueue> &queue)
+{
+    queue->detach();
+    {
+        std::lock_guard<std::mutex> lock(queues_mutex_);
+        queues_.erase(std::remove(queues_.begin(), queues_.end(), queue), queues_.end());
+    }
+
+    // A handler of this worker removing a queue is the drain in progress, it stops once the handler returns.
+    if (std::this_thread::get_id() != thread_.get_id())
+    {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+    }
+}
+
+void ReceiveWorker::notify()
+{
+    // Pairs with the fence in run(): either the worker sees the new message or we see it sleeping.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed))
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex_);
+            ++wakeups_;
+        }
+        wakeup_.notify_one();
+    }
+}
+
+bool ReceiveWorker::all_empty()
+{
+    std::lock_guard<std::mutex> lock(queues_mutex_);
+    return std::all_of(queues_.begin(), queues_.end(), [](const std::shared_ptr<ReceiveQueue> &queue)
+    {
+        return queue->empty();
+    });
+}
+
+void ReceiveWorker::run()
+{
+    while (running_.load())
+    {
+        // Handlers may attach and detach receivers of this worker, the queues are drained from a copy of the list.
+        {
+            std::lock_guard<std::mutex> lock(queues_mutex_);
+            draining_.assign(queues_.begin(), queues_.end());
+        }
+
+        bool handled = false;
+        for (auto &queue : draining_)
+        {
+            std::lock_guard<std::mutex> lock(drain_mutex_);
+            handled |= queue->drain(s_maxMessagesPerDrain);
+        }
+        draining_.clear();
+
+        if (handled)
+        {
+            continue;
+        }
+
+        uint64_t seen;
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex_);
+            seen = wakeups_;
+        }
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (all_empty())
+        {
+            std::unique_lock<std::mutex> lock(wakeup_mutex_);
+            wakeup_.wait(lock, [&]()
+            {
+                return wakeups_ != seen;
+            });
+        }
+
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+ReceiveDispatcher::ReceiveDispatcher(
+    uint32_t workers,
+    uint32_t queue_depth)
+    : queue_depth_(std::max<uint32_t>(queue_depth, 1))
+    , next_(0)
+{
+    workers = std::max<uint32_t>(workers, 1);
+    for (uint32_t i = 0; i < workers; ++i)
+    {
+        workers_.emplace_back(new ReceiveWorker());
+    }
+}
+
+ReceiveDispatcher::~ReceiveDispatcher()
+{
+}
+
+std::shared_ptr<ReceiveQueue> ReceiveDispatcher::attach(
+    const MetadataReceiveCallback &handler)
+{
+    ReceiveWorker *worker = workers_[next_.fetch_add(1) % workers_.size()].get();
+    auto queue = std::make_shared<ReceiveQueue>(queue_depth_, handler, worker);
+    worker->add(queue);
+    return queue;
+}
+
+void ReceiveDispatcher::detach(
+    const std::shared_ptr<ReceiveQueue> &queue)
+{
+    if (queue)
+    {
+        queue->worker()->remove(queue);
+    }
+}
+
+} // namespace transport
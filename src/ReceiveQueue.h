@@ -0,0 +1,167 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ReceiveQueue.h
+ *
+ */
+
+#ifndef TRANSPORT_RECEIVE_QUEUE_H_
+#define TRANSPORT_RECEIVE_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <transport/ReceiverResource.h>
+
+namespace transport
+{
+
+class ReceiveWorker;
+
+/**
+ * Bounded single producer / single consumer queue of received messages.
+ * The producer is the loop thread of the receiver, the consumer the worker servicing the queue,
+ * so messages of a receiver are always handled in order. Slots keep their buffers between messages,
+ * hence no allocation happens once every slot has seen a message of the maximum size.
+ */
+class ReceiveQueue
+{
+public:
+    ReceiveQueue(
+        uint32_t capacity,
+        const MetadataReceiveCallback &handler,
+        ReceiveWorker *worker);
+
+    /**
+     * Copies a message into the queue and wakes up the worker.
+     * @return false when the queue is full and the message has been dropped.
+     */
+    bool push(
+        const unsigned char *data,
+        uint32_t size,
+        const Locator &local_locator,
+        const Locator &remote_locator,
+        const ReceiveMetadata &metadata);
+
+    /**
+     * Hands up to max_messages queued messages to the handler. Consumer side only.
+     * Stops as soon as the queue is detached, which the handler itself may do.
+     * @return true if at least one message was handled.
+     */
+    bool drain(
+        uint32_t max_messages);
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    ReceiveWorker *worker() const
+    {
+        return worker_;
+    }
+
+    //! Stops the handling of the messages of the queue.
+    void detach()
+    {
+        detached_.store(true, std::memory_order_release);
+    }
+
+    bool detached() const
+    {
+        return detached_.load(std::memory_order_acquire);
+    }
+
+    //! Number of messages dropped because the queue was full.
+    uint32_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot
+    {
+        std::vector<unsigned char> data;
+        Locator local_locator;
+        Locator remote_locator;
+        ReceiveMetadata metadata;
+    };
+
+    std::vector<Slot> slots_;
+    uint32_t mask_;
+    MetadataReceiveCallback handler_;
+    ReceiveWorker *worker_;
+
+    //! Next slot to be consumed.
+    std::atomic<uint32_t> head_;
+    //! Next slot to be produced.
+    std::atomic<uint32_t> tail_;
+    std::atomic<uint32_t> dropped_;
+    std::atomic<bool> detached_;
+};
+
+/**
+ * Thread servicing a set of ReceiveQueues. It sleeps while all of them are empty.
+ */
+class ReceiveWorker
+{
+public:
+    ReceiveWorker();
+
+    ~ReceiveWorker();
+
+    void add(
+        const std::shared_ptr<ReceiveQueue> &queue);
+
+    /**
+     * Removes a queue. Once it returns the worker no longer hands its messages to the handler.
+     * When called by a handler run by this worker, the message being handled is the last one.
+     */
+    void remove(
+        const std::shared_ptr<ReceiveQueue> &queue);
+
+    //! Called by the producers after a push.
+    void notify();
+
+private:
+    void run();
+
+    bool all_empty();
+
+    //! Guards the list of queues only, the worker drains a copy of it.
+    std::mutex queues_mutex_;
+    std::vector<std::shared_ptr<ReceiveQueue>> queues_;
+
+    //! Copy of the list being drained, reused across iterations. Worker thread only.
+    std::vector<std::shared_ptr<ReceiveQueue>> draining_;
+
+    //! Held while a queue is drained, so that remove can wait for the handler to return.
+    std::mutex drain_mutex_;
+
+    std::mutex wakeup_mutex_;
+    std::condition_variable wakeup_;
+    uint64_t wakeups_;
+    std::atomic<bool> sleeping_;
+    std::atomic<bool> running_;
+
+    std::thread thread_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_RECEIVE_QUEUE_H_
@@ -0,0 +1,118 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <transport/ReceiverResource.h>
+#include <transport/ReceiveDispatcher.h>
+#include "ReceiveQueue.h"
+#include <cstring>
+
+namespace transport
+{
+
+ReceiverResource::~ReceiverResource()
+{
+    set_dispatcher(nullptr);
+    direct_receiver_.store(nullptr, std::memory_order_relaxed);
+    locator_check_callback_ = nullptr;
+    metadata_callback_ = nullptr;
+    recv_callback_ = nullptr;
+}
+
+void ReceiverResource::set_dispatcher(
+    const std::shared_ptr<ReceiveDispatcher> &dispatcher)
+{
+    if (dispatcher_)
+    {
+        dispatcher_->detach(queue_);
+        queue_.reset();
+    }
+
+    dispatcher_ = dispatcher;
+
+    if (dispatcher_)
+    {
+        queue_ = dispatcher_->attach([this](const unsigned char* data,
+                                    const uint32_t size,
+                                    const Locator& local_locator,
+                                    const Locator& remote_locator,
+                                    const ReceiveMetadata& metadata)
+        {
+            invoke(data, size, local_locator, remote_locator, metadata);
+        });
+    }
+}
+
+void ReceiverResource::set_origin_filter(
+    uint32_t offset,
+    const std::vector<octet> &origin)
+{
+    origin_offset_ = offset;
+    origin_ = origin;
+}
+
+ReceiverStatistics ReceiverResource::statistics() const
+{
+    ReceiverStatistics stats;
+    stats.dispatch_drops = (queue_ ? queue_->dropped() : 0) + mailbox_drops_.load(std::memory_order_relaxed);
+    stats.origin_drops = origin_drops_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ReceiverResource::deliver(
+    const unsigned char* data,
+    const uint32_t size,
+    const Locator& local_locator,
+    const Locator& remote_locator,
+    const ReceiveMetadata& metadata)
+{
+    if (!origin_.empty() && size >= origin_offset_ + origin_.size() &&
+            memcmp(data + origin_offset_, origin_.data(), origin_.size()) == 0)
+    {
+        origin_drops_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (queue_)
+    {
+        queue_->push(data, size, local_locator, remote_locator, metadata);
+    }
+    else
+    {
+        invoke(data, size, local_locator, remote_locator, metadata);
+    }
+}
+
+void ReceiverResource::invoke(
+    const unsigned char* data,
+    const uint32_t size,
+    const Locator& local_locator,
+    const Locator& remote_locator,
+    const ReceiveMetadata& metadata)
+{
+    const DirectReceiver *direct = direct_receiver_.load(std::memory_order_acquire);
+    if (direct)
+    {
+        direct->handler(direct->context, data, size, local_locator, remote_locator, metadata);
+    }
+    else if (metadata_callback_)
+    {
+        metadata_callback_(data, size, local_locator, remote_locator, metadata);
+    }
+    else if (recv_callback_)
+    {
+        recv_callback_(data, size, local_locator, remote_locator);
+    }
+}
+
+} // namespace transport
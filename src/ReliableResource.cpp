@@ -0,0 +1,448 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ReliableResource.cpp
+ *
+ */
+
+#include "ReliableResource.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace transport
+{
+
+//! Marks datagrams of the reliable protocol ("TR").
+constexpr uint16_t s_reliableHeaderMagic = 0x5452;
+
+//! Number of sequence numbers a single NACK can request.
+constexpr uint64_t s_nackBitmapSize = 64;
+
+enum ReliableMessageType : octet
+{
+    RELIABLE_DATA = 1,
+    RELIABLE_HEARTBEAT = 2,
+    RELIABLE_NACK = 3
+};
+
+static void write_u32(
+    octet *buffer,
+    uint32_t value)
+{
+    for (int i = 3; i >= 0; --i, value >>= 8)
+    {
+        buffer[i] = static_cast<octet>(value);
+    }
+}
+
+static void write_u64(
+    octet *buffer,
+    uint64_t value)
+{
+    for (int i = 7; i >= 0; --i, value >>= 8)
+    {
+        buffer[i] = static_cast<octet>(value);
+    }
+}
+
+static uint32_t read_u32(
+    const octet *buffer)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        value = (value << 8) | buffer[i];
+    }
+    return value;
+}
+
+static uint64_t read_u64(
+    const octet *buffer)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        value = (value << 8) | buffer[i];
+    }
+    return value;
+}
+
+static void write_header(
+    octet *buffer,
+    octet type,
+    uint32_t writer_id,
+    uint64_t sequence)
+{
+    buffer[0] = static_cast<octet>(s_reliableHeaderMagic >> 8);
+    buffer[1] = static_cast<octet>(s_reliableHeaderMagic & 0xFF);
+    buffer[2] = type;
+    buffer[3] = 0;
+    write_u32(buffer + 4, writer_id);
+    write_u64(buffer + 8, sequence);
+}
+
+static bool read_header(
+    const octet *buffer,
+    uint32_t size,
+    octet &type,
+    uint32_t &writer_id,
+    uint64_t &sequence)
+{
+    if (size < s_reliableHeaderSize ||
+            buffer[0] != static_cast<octet>(s_reliableHeaderMagic >> 8) ||
+            buffer[1] != static_cast<octet>(s_reliableHeaderMagic & 0xFF))
+    {
+        return false;
+    }
+
+    type = buffer[2];
+    writer_id = read_u32(buffer + 4);
+    sequence = read_u64(buffer + 8);
+    return true;
+}
+
+ReliableSenderResource::ReliableSenderResource(
+    std::shared_ptr<SenderResource> network_sender,
+    const ReliabilityConfig &config)
+    : SenderResource()
+    , network_sender_(network_sender)
+    , writer_id_(std::random_device()())
+    , history_(std::max<uint32_t>(config.history_depth, 1))
+    , next_sequence_(1)
+{
+    send_lambda_ = [this](
+                        const octet *data,
+                        uint32_t dataSize,
+                        const LocatorList &locators,
+                        const std::chrono::steady_clock::time_point &max_blocking_time_point) -> bool
+    {
+        return send_data(data, dataSize, locators, max_blocking_time_point);
+    };
+}
+
+ReliableSenderResource::~ReliableSenderResource()
+{
+    if (stop_heartbeat_)
+    {
+        stop_heartbeat_();
+    }
+}
+
+bool ReliableSenderResource::send_data(
+    const octet *data,
+    uint32_t size,
+    const LocatorList &locators,
+    const std::chrono::steady_clock::time_point &max_blocking_time_point)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint64_t sequence = next_sequence_++;
+    Slot &slot = history_[sequence % history_.size()];
+    if (slot.data.size() < size + s_reliableHeaderSize)
+    {
+        slot.data.resize(size + s_reliableHeaderSize);
+    }
+
+    write_header(slot.data.data(), RELIABLE_DATA, writer_id_, sequence);
+    memcpy(slot.data.data() + s_reliableHeaderSize, data, size);
+    slot.sequence = sequence;
+    slot.size = size + s_reliableHeaderSize;
+
+    if (!(destinations_ == locators))
+    {
+        destinations_ = locators;
+    }
+
+    // A message lost on its way is repaired through the history, so its failure is not reported.
+    network_sender_->send(slot.data.data(), slot.size, locators, max_blocking_time_point);
+    return true;
+}
+
+void ReliableSenderResource::on_control(
+    const octet *data,
+    uint32_t size,
+    const Locator &remote_locator)
+{
+    octet type;
+    uint32_t writer_id;
+    uint64_t base;
+    if (!read_header(data, size, type, writer_id, base) || type != RELIABLE_NACK ||
+            writer_id != writer_id_ || size < s_reliableControlSize)
+    {
+        return;
+    }
+
+    uint64_t bitmap = read_u64(data + s_reliableHeaderSize);
+    LocatorList reader;
+    reader.push_back(remote_locator);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint64_t i = 0; i < s_nackBitmapSize; ++i)
+    {
+        if ((bitmap & (uint64_t(1) << i)) == 0)
+        {
+            continue;
+        }
+
+        const Slot &slot = history_[(base + i) % history_.size()];
+        if (slot.sequence == base + i)
+        {
+            network_sender_->send(slot.data.data(), slot.size, reader, std::chrono::steady_clock::now());
+        }
+    }
+}
+
+void ReliableSenderResource::send_heartbeat()
+{
+    octet message[s_reliableControlSize];
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (next_sequence_ == 1 || destinations_.empty())
+    {
+        return;
+    }
+
+    uint64_t last = next_sequence_ - 1;
+    uint64_t first_available = next_sequence_ > history_.size() ? next_sequence_ - history_.size() : 1;
+
+    write_header(message, RELIABLE_HEARTBEAT, writer_id_, last);
+    write_u64(message + s_reliableHeaderSize, first_available);
+    network_sender_->send(message, s_reliableControlSize, destinations_, std::chrono::steady_clock::now());
+}
+
+ReliableReceiverResource::ReliableReceiverResource(
+    std::shared_ptr<ReceiverResource> network_receiver,
+    std::shared_ptr<SenderResource> nack_sender,
+    const ReliabilityConfig &config)
+    : ReceiverResource(network_receiver->locator(),
+            std::max(network_receiver->max_message_size(), s_reliableHeaderSize) - s_reliableHeaderSize)
+    , network_receiver_(network_receiver)
+    , nack_sender_(nack_sender)
+    , window_depth_(std::max<uint32_t>(config.window_depth, 1))
+    , writer_timeout_(config.writer_timeout)
+    , last_expiry_(std::chrono::steady_clock::now())
+    , lost_messages_(0)
+{
+    locator_check_callback_ = [this](const Locator &locatorToCheck) -> bool
+    {
+        return network_receiver_->support_locator(locatorToCheck);
+    };
+}
+
+void ReliableReceiverResource::register_receiver(
+    const ReceiveCallback &callback)
+{
+    recv_callback_ = callback;
+}
+
+ReceiverStatistics ReliableReceiverResource::statistics() const
+{
+    ReceiverStatistics stats = network_receiver_->statistics();
+    ReceiverStatistics own = ReceiverResource::statistics();
+    stats.dispatch_drops = own.dispatch_drops;
+    stats.origin_drops = own.origin_drops;
+    stats.lost_messages = lost_messages_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ReliableReceiverResource::on_message(
+    const unsigned char* data,
+    const uint32_t size,
+    const Locator& local_locator,
+    const Locator& remote_locator,
+    const ReceiveMetadata& metadata)
+{
+    octet type;
+    uint32_t writer_id;
+    uint64_t sequence;
+    if (!read_header(data, size, type, writer_id, sequence) || sequence == 0)
+    {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    expire_writers(now);
+
+    auto it = writers_.find(writer_id);
+    if (it == writers_.end())
+    {
+        // Late joiners start with the first message they see, the previous ones are not requested.
+        WriterState state;
+        state.next = type == RELIABLE_DATA ? sequence : sequence + 1;
+        state.last_known = sequence;
+        state.window.resize(window_depth_);
+        it = writers_.emplace(writer_id, std::move(state)).first;
+    }
+
+    WriterState &writer = it->second;
+    writer.remote_locator = remote_locator;
+    writer.last_seen = now;
+
+    if (type == RELIABLE_HEARTBEAT && size >= s_reliableControlSize)
+    {
+        uint64_t first_available = read_u64(data + s_reliableHeaderSize);
+        writer.last_known = std::max(writer.last_known, sequence);
+        if (first_available > writer.next)
+        {
+            skip_to(writer, first_available);
+        }
+        if (writer.last_known >= writer.next)
+        {
+            send_nack(writer_id, writer);
+        }
+        return;
+    }
+
+    if (type != RELIABLE_DATA || sequence < writer.next)
+    {
+        return;
+    }
+
+    writer.last_known = std::max(writer.last_known, sequence);
+
+    if (sequence - writer.next >= window_depth_)
+    {
+        skip_to(writer, sequence - window_depth_ + 1);
+    }
+
+    if (sequence == writer.next)
+    {
+        deliver(data + s_reliableHeaderSize, size - s_reliableHeaderSize, local_locator, remote_locator, metadata);
+        ++writer.next;
+        deliver_ready(writer);
+        return;
+    }
+
+    Sample &sample = writer.window[sequence % window_depth_];
+    if (!sample.present)
+    {
+        if (sample.data.size() < size - s_reliableHeaderSize)
+        {
+            sample.data.resize(size - s_reliableHeaderSize);
+        }
+        memcpy(sample.data.data(), data + s_reliableHeaderSize, size - s_reliableHeaderSize);
+        sample.size = size - s_reliableHeaderSize;
+        sample.sequence = sequence;
+        sample.local_locator = local_locator;
+        sample.metadata = metadata;
+        sample.present = true;
+    }
+
+    send_nack(writer_id, writer);
+}
+
+void ReliableReceiverResource::deliver_ready(
+    WriterState &writer)
+{
+    for (;;)
+    {
+        Sample &sample = writer.window[writer.next % window_depth_];
+        if (!sample.present || sample.sequence != writer.next)
+        {
+            return;
+        }
+
+        sample.present = false;
+        deliver(sample.data.data(), sample.size, sample.local_locator, writer.remote_locator, sample.metadata);
+        ++writer.next;
+    }
+}
+
+void ReliableReceiverResource::skip_to(
+    WriterState &writer,
+    uint64_t sequence)
+{
+    // Sequence numbers come from the wire, only the slots of the window are walked.
+    uint64_t window_end = writer.next + std::min<uint64_t>(sequence - writer.next, window_depth_);
+    while (writer.next < window_end)
+    {
+        Sample &sample = writer.window[writer.next % window_depth_];
+        if (sample.present && sample.sequence == writer.next)
+        {
+            sample.present = false;
+            deliver(sample.data.data(), sample.size, sample.local_locator, writer.remote_locator, sample.metadata);
+        }
+        else
+        {
+            lost_messages_.fetch_add(1, std::memory_order_relaxed);
+        }
+        ++writer.next;
+    }
+
+    // Nothing beyond the window is held, the rest of the gap is lost as a whole.
+    if (writer.next < sequence)
+    {
+        lost_messages_.fetch_add(static_cast<uint32_t>(std::min<uint64_t>(sequence - writer.next,
+                std::numeric_limits<uint32_t>::max())), std::memory_order_relaxed);
+        writer.next = sequence;
+    }
+
+    deliver_ready(writer);
+}
+
+void ReliableReceiverResource::expire_writers(
+    std::chrono::steady_clock::time_point now)
+{
+    if (now - last_expiry_ < writer_timeout_)
+    {
+        return;
+    }
+    last_expiry_ = now;
+
+    // The messages still waiting in the window of a writer that went away will never be completed.
+    for (auto it = writers_.begin(); it != writers_.end();)
+    {
+        if (now - it->second.last_seen >= writer_timeout_)
+        {
+            it = writers_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void ReliableReceiverResource::send_nack(
+    uint32_t writer_id,
+    const WriterState &writer)
+{
+    uint64_t bitmap = 0;
+    for (uint64_t i = 0; i < s_nackBitmapSize && writer.next + i <= writer.last_known; ++i)
+    {
+        const Sample &sample = writer.window[(writer.next + i) % window_depth_];
+        if (!sample.present || sample.sequence != writer.next + i)
+        {
+            bitmap |= uint64_t(1) << i;
+        }
+    }
+
+    if (bitmap == 0)
+    {
+        return;
+    }
+
+    octet message[s_reliableControlSize];
+    write_header(message, RELIABLE_NACK, writer_id, writer.next);
+    write_u64(message + s_reliableHeaderSize, bitmap);
+
+    LocatorList writer_locator;
+    writer_locator.push_back(writer.remote_locator);
+    nack_sender_->send(message, s_reliableControlSize, writer_locator, std::chrono::steady_clock::now());
+}
+
+} // namespace transport
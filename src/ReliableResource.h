@@ -0,0 +1,197 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ReliableResource.h
+ *
+ */
+
+#ifndef TRANSPORT_RELIABLE_RESOURCE_H_
+#define TRANSPORT_RELIABLE_RESOURCE_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <transport/ReceiverResource.h>
+#include <transport/SenderResource.h>
+#include <transport/TransportFactory.h>
+
+namespace transport
+{
+
+/**
+ * Header of the reliable protocol: 2 bytes of magic, the message type, a reserved byte,
+ * the 4 bytes of the writer id and an 8 bytes sequence number, in network byte order.
+ * DATA messages carry the payload after it, HEARTBEAT and NACK messages 8 more bytes.
+ */
+constexpr uint32_t s_reliableHeaderSize = 16;
+//! Size of the HEARTBEAT and NACK messages.
+constexpr uint32_t s_reliableControlSize = s_reliableHeaderSize + 8;
+
+/**
+ * Writer side of a reliable channel.
+ * Every message gets the next sequence number of the writer and is kept in a history ring,
+ * from which the messages requested by NACKs are sent again to the reader asking for them.
+ * Slots keep their buffers, so no allocation happens once every slot has held a message of the maximum size.
+ */
+class ReliableSenderResource : public SenderResource
+{
+    friend class TransportFactory;
+
+public:
+    ReliableSenderResource(
+        std::shared_ptr<SenderResource> network_sender,
+        const ReliabilityConfig &config);
+
+    ~ReliableSenderResource();
+
+    virtual Locator locator() const final
+    {
+        return network_sender_->locator();
+    }
+
+    virtual bool set_multicast_loopback(
+        bool enable) override
+    {
+        return network_sender_->set_multicast_loopback(enable);
+    }
+
+    //! Handles a datagram received on the channel of the writer, where readers send their NACKs.
+    void on_control(
+        const octet *data,
+        uint32_t size,
+        const Locator &remote_locator);
+
+    //! Announces the range of sequence numbers available in the history to the last destinations.
+    void send_heartbeat();
+
+private:
+    struct Slot
+    {
+        uint64_t sequence = 0;
+        uint32_t size = 0;
+        std::vector<octet> data;
+    };
+
+    bool send_data(
+        const octet *data,
+        uint32_t size,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point);
+
+    std::shared_ptr<SenderResource> network_sender_;
+    uint32_t writer_id_;
+
+    std::mutex mutex_;
+    std::vector<Slot> history_;
+    uint64_t next_sequence_;
+    //! Destinations of the last message, target of the heartbeats.
+    LocatorList destinations_;
+
+    //! Stops and closes the heartbeat timer on its loop, from any thread. Set by TransportFactory.
+    std::function<void()> stop_heartbeat_;
+};
+
+/**
+ * Reader side of a reliable channel.
+ * Messages of each writer are delivered in sequence order. Out of order messages wait in a window ring
+ * while the missing ones are requested with a NACK; messages that are no longer available or do not fit
+ * in the window are given up and accounted in ReceiverStatistics::lost_messages.
+ */
+class ReliableReceiverResource : public ReceiverResource
+{
+public:
+    /**
+     * @param network_receiver Receiver of the underlying channel.
+     * @param nack_sender Sender bound to the socket of network_receiver, so that writers send
+     * retransmissions back to it.
+     * @param config Reliability configuration.
+     */
+    ReliableReceiverResource(
+        std::shared_ptr<ReceiverResource> network_receiver,
+        std::shared_ptr<SenderResource> nack_sender,
+        const ReliabilityConfig &config);
+
+    void register_receiver(
+        const ReceiveCallback &callback) override;
+
+    ReceiverStatistics statistics() const override;
+
+    //! Handles a datagram of the underlying channel. Always called from the same thread.
+    void on_message(
+        const unsigned char* data,
+        const uint32_t size,
+        const Locator& local_locator,
+        const Locator& remote_locator,
+        const ReceiveMetadata& metadata);
+
+private:
+    struct Sample
+    {
+        uint64_t sequence = 0;
+        bool present = false;
+        uint32_t size = 0;
+        std::vector<octet> data;
+        Locator local_locator;
+        ReceiveMetadata metadata;
+    };
+
+    struct WriterState
+    {
+        //! Next sequence number to be delivered.
+        uint64_t next = 0;
+        //! Highest sequence number known to be sent by the writer.
+        uint64_t last_known = 0;
+        Locator remote_locator;
+        std::vector<Sample> window;
+        //! Reception time of the last message of the writer.
+        std::chrono::steady_clock::time_point last_seen;
+    };
+
+    //! Delivers the consecutive messages waiting in the window.
+    void deliver_ready(
+        WriterState &writer);
+
+    //! Gives up the messages before sequence, delivering the ones waiting in the window.
+    void skip_to(
+        WriterState &writer,
+        uint64_t sequence);
+
+    //! Requests the missing messages of a writer.
+    void send_nack(
+        uint32_t writer_id,
+        const WriterState &writer);
+
+    //! Forgets the writers not heard from for writer_timeout_, at most once per writer_timeout_.
+    void expire_writers(
+        std::chrono::steady_clock::time_point now);
+
+    std::shared_ptr<ReceiverResource> network_receiver_;
+    std::shared_ptr<SenderResource> nack_sender_;
+    uint32_t window_depth_;
+    std::chrono::steady_clock::duration writer_timeout_;
+
+    std::unordered_map<uint32_t, WriterState> writers_;
+    std::chrono::steady_clock::time_point last_expiry_;
+
+    std::atomic<uint32_t> lost_messages_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_RELIABLE_RESOURCE_H_
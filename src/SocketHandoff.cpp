@@ -0,0 +1,268 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file SocketHandoff.cpp
+ *
+ */
+
+#include "SocketHandoff.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace transport
+{
+
+//! Bumped whenever the layout of HandoffRecord changes.
+constexpr uint32_t s_handoffVersion = 1;
+
+/**
+ * Payload of a record. Both processes run on the same host, so it is sent in host layout.
+ */
+struct HandoffRecord
+{
+    uint32_t version;
+    int32_t kind;
+    uint32_t port;
+    octet address[16];
+    uint8_t input;
+    uint8_t priority;
+};
+
+static bool make_address(
+    const std::string &path,
+    sockaddr_un &address)
+{
+    memset(&address, 0, sizeof(address));
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+static int remaining_ms(
+    const std::chrono::steady_clock::time_point &deadline)
+{
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    return static_cast<int>(std::max<int64_t>(remaining, 0));
+}
+
+//! Removes the socket left at path by a previous handoff. Anything else at path is left alone.
+static bool unlink_socket(
+    const std::string &path)
+{
+    struct stat status;
+    if (::lstat(path.c_str(), &status) != 0)
+    {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(status.st_mode))
+    {
+        return false;
+    }
+    return ::unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+
+bool SocketHandoff::send(
+    const std::string &path,
+    const std::vector<HandoffSocket> &sockets,
+    std::chrono::milliseconds timeout)
+{
+    sockaddr_un address;
+    if (!make_address(path, address))
+    {
+        return false;
+    }
+
+    int listener = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+    {
+        return false;
+    }
+
+    if (!unlink_socket(path) ||
+            ::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listener, 1) != 0)
+    {
+        ::close(listener);
+        return false;
+    }
+
+    int peer = -1;
+    pollfd listener_poll = {listener, POLLIN, 0};
+    if (::poll(&listener_poll, 1, static_cast<int>(timeout.count())) > 0)
+    {
+        peer = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    }
+
+    ::close(listener);
+    unlink_socket(path);
+    if (peer < 0)
+    {
+        return false;
+    }
+
+    bool sent = true;
+    for (const HandoffSocket &socket : sockets)
+    {
+        HandoffRecord record = {};
+        record.version = s_handoffVersion;
+        record.kind = socket.locator.kind;
+        record.port = socket.locator.port;
+        memcpy(record.address, socket.locator.address, sizeof(record.address));
+        record.input = socket.input ? 1 : 0;
+        record.priority = static_cast<uint8_t>(socket.priority);
+
+        iovec iov = {&record, sizeof(record)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+        msghdr message = {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &socket.fd, sizeof(int));
+
+        if (::sendmsg(peer, &message, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(record)))
+        {
+            sent = false;
+            break;
+        }
+    }
+
+    // The adopting process reads the end of the list from the closed connection.
+    ::close(peer);
+    return sent;
+}
+
+bool SocketHandoff::receive(
+    const std::string &path,
+    std::vector<HandoffSocket> &sockets,
+    std::chrono::milliseconds timeout)
+{
+    sockaddr_un address;
+    if (!make_address(path, address))
+    {
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    // The exporting process may not be listening yet.
+    while (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        if ((errno != ENOENT && errno != ECONNREFUSED) || std::chrono::steady_clock::now() >= deadline)
+        {
+            ::close(fd);
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::vector<HandoffSocket> received;
+    bool complete = false;
+    for (;;)
+    {
+        pollfd peer_poll = {fd, POLLIN, 0};
+        if (::poll(&peer_poll, 1, remaining_ms(deadline)) <= 0)
+        {
+            break;
+        }
+
+        HandoffRecord record = {};
+        iovec iov = {&record, sizeof(record)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+        msghdr message = {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t length = ::recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+        if (length == 0)
+        {
+            complete = true;
+            break;
+        }
+
+        int socket_fd = -1;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&message); length > 0 && cmsg; cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+            {
+                memcpy(&socket_fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+
+        if (length != static_cast<ssize_t>(sizeof(record)) || record.version != s_handoffVersion ||
+                socket_fd < 0 || (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)))
+        {
+            if (socket_fd >= 0)
+            {
+                ::close(socket_fd);
+            }
+            break;
+        }
+
+        HandoffSocket socket;
+        socket.locator.kind = record.kind;
+        socket.locator.port = record.port;
+        memcpy(socket.locator.address, record.address, sizeof(record.address));
+        socket.input = record.input != 0;
+        socket.priority = static_cast<TrafficPriority>(record.priority);
+        socket.fd = socket_fd;
+        received.push_back(socket);
+    }
+
+    ::close(fd);
+
+    // A partial list is dropped, the exporting process still owns every socket.
+    if (!complete)
+    {
+        for (const HandoffSocket &socket : received)
+        {
+            ::close(socket.fd);
+        }
+        return false;
+    }
+
+    sockets.insert(sockets.end(), received.begin(), received.end());
+    return true;
+}
+
+} // namespace transport
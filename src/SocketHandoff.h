@@ -0,0 +1,68 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file SocketHandoff.h
+ *
+ */
+
+#ifndef TRANSPORT_SOCKET_HANDOFF_H_
+#define TRANSPORT_SOCKET_HANDOFF_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <transport/type.h>
+#include <transport/TransportInterface.h>
+
+namespace transport
+{
+
+/**
+ * Transfer of the sockets of a process to the process replacing it, over a Unix domain socket.
+ * The exporting side listens on the path and the adopting side connects to it, so either one can be
+ * started first. Every socket travels in its own SOCK_SEQPACKET record, along with its locator,
+ * direction and priority, and its descriptor attached as SCM_RIGHTS ancillary data.
+ * The connection is closed once the last record is sent.
+ */
+namespace SocketHandoff
+{
+
+/**
+ * Waits for the adopting process and sends it the sockets.
+ * @param path Path of the Unix domain socket, replaced if it is a socket. Fails if it is any other file.
+ * @param sockets Sockets to send, still owned by the caller.
+ * @param timeout Maximum time to wait for the adopting process.
+ */
+bool send(
+    const std::string &path,
+    const std::vector<HandoffSocket> &sockets,
+    std::chrono::milliseconds timeout);
+
+/**
+ * Connects to the exporting process and receives its sockets.
+ * @param path Path of the Unix domain socket.
+ * @param[out] sockets Received sockets, owned by the caller.
+ * @param timeout Maximum time to wait for the exporting process to listen and send the sockets.
+ */
+bool receive(
+    const std::string &path,
+    std::vector<HandoffSocket> &sockets,
+    std::chrono::milliseconds timeout);
+
+} // namespace SocketHandoff
+
+} // namespace transport
+
+#endif // TRANSPORT_SOCKET_HANDOFF_H_
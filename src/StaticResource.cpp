@@ -0,0 +1,49 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file StaticResource.cpp
+ *
+ */
+
+#include <transport/StaticResource.h>
+#include <uvw.hpp>
+#include "udp/UDPSenderResource.hpp"
+
+namespace transport
+{
+
+template<typename Descriptor>
+StaticSenderResource<Descriptor>::StaticSenderResource(
+    std::shared_ptr<SenderResource> resource)
+    : resource_(resource)
+    // The factory only hands out senders built by the transport of the descriptor.
+    , sender_(static_cast<typename StaticTransportTraits<Descriptor>::Sender *>(resource.get()))
+{
+}
+
+template<typename Descriptor>
+bool StaticSenderResource<Descriptor>::send(
+    const octet *data,
+    uint32_t dataLength,
+    const LocatorList &locators,
+    const std::chrono::steady_clock::time_point &max_blocking_time_point)
+{
+    return sender_->send_direct(data, dataLength, locators, max_blocking_time_point);
+}
+
+template class StaticSenderResource<TransportDescriptor<UDPv4Descriptor>>;
+template class StaticSenderResource<TransportDescriptor<UDPv6Descriptor>>;
+
+} // namespace transport
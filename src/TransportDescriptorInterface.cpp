@@ -16,6 +16,7 @@
 #include <uvw.hpp>
 #include "udp/UDPv4Transport.h"
 #include "udp/UDPv6Transport.h"
+#include "uds/UDSTransport.h"
 
 
 namespace transport
@@ -44,4 +45,15 @@ int32_t TransportDescriptor<UDPv6Descriptor>::transport_kind() const
     return LOCATOR_KIND_UDPv6;
 }
 
+TransportInterface *TransportDescriptor<UDSDescriptor>::create_transport(std::shared_ptr<uvw::loop> loop) const
+{
+    return new UDSTransport(
+        loop, std::make_shared<TransportDescriptor<UDSDescriptor>>(*this));
+}
+
+int32_t TransportDescriptor<UDSDescriptor>::transport_kind() const
+{
+    return LOCATOR_KIND_UDS;
+}
+
 } // namespace transport
\ No newline at end of file
@@ -14,8 +14,19 @@
 
 #include <transport/TransportFactory.h>
 #include <algorithm>
+#include <unistd.h>
 #include <uvw.hpp>
+#include "IPFinder.h"
 #include "IPLocator.h"
+#include "LoopPool.h"
+#include "IntraProcessMailbox.h"
+#include "IntraProcessSenderResource.hpp"
+#include "ChannelResource.h"
+#include "ReliableResource.h"
+#include "SocketHandoff.h"
+#include "udp/UDPSenderResource.hpp"
+#include "uds/UDSTransport.h"
+#include "uds/UDSSenderResource.hpp"
 
 namespace transport
 {
@@ -23,8 +34,83 @@ namespace transport
 static ReceiverResourceList receiver_resources_list;
 static SendResourceList sender_resource_list;
 
+/**
+ * Snapshot read by the intra-process senders. It is never modified once published,
+ * so senders only need to load the pointer.
+ */
+struct IntraProcessView
+{
+    //! Receiver of this factory, with the mailbox of its loop.
+    struct Receiver
+    {
+        std::shared_ptr<ReceiverResource> resource;
+        std::shared_ptr<IntraProcessMailbox> mailbox;
+    };
+
+    std::vector<Receiver> receivers;
+    //! Addresses of the local interfaces, loopback included.
+    LocatorList addresses;
+
+    //! Reports whether an IP locator points to this host.
+    bool is_local_host(
+        const Locator &locator) const
+    {
+        return IPLocator::isLocal(locator) ||
+               std::any_of(addresses.begin(), addresses.end(), [&locator](const Locator &address)
+        {
+            return IPLocator::compareAddress(address, locator);
+        });
+    }
+
+    //! Returns the receiver listening on a unicast destination, nullptr if there is none.
+    const Receiver *find(
+        const Locator &destination) const
+    {
+        if (IPLocator::isMulticast(destination))
+        {
+            // Other processes may have joined the group too.
+            return nullptr;
+        }
+
+        for (auto &receiver : receivers)
+        {
+            Locator local = receiver.resource->locator();
+            if (local.kind == destination.kind && local.port == destination.port &&
+                    (IPLocator::compareAddress(local, destination, true) ||
+                    (IPLocator::isAny(local) && is_local_host(destination))))
+            {
+                return &receiver;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+/**
+ * Cost of reaching a locator, lower is cheaper.
+ */
+enum class LocatorCost
+{
+    INTRA_PROCESS,
+    SHARED_MEMORY,
+    UNIX_DOMAIN,
+    LOCAL_HOST,
+    NETWORK
+};
+
+//! Size of the network channel carrying messages of the given size behind a header, saturated.
+static uint32_t with_header(
+    uint32_t message_size,
+    uint32_t header_size)
+{
+    return std::min(message_size, std::numeric_limits<uint32_t>::max() - header_size) + header_size;
+}
+
 TransportFactory::TransportFactory(std::shared_ptr<uvw::loop> loop)
     : loop_(loop)
+    , loop_policy_(LoopPolicy::ROUND_ROBIN)
+    , intra_process_view_(std::make_shared<IntraProcessView>())
     , max_message_size_between_transports_(std::numeric_limits<uint32_t>::max())
     , min_send_buffer_size_(std::numeric_limits<uint32_t>::max())
 {
@@ -32,55 +118,907 @@ TransportFactory::TransportFactory(std::shared_ptr<uvw::loop> loop)
     {
         loop_ = uvw::loop::get_default();
     }
+
+    open_mailboxes();
+
+    // The addresses of this host are known before the first receiver, so that no locator of its own
+    // is taken for a remote one.
+    update_intra_process_view(nullptr, 0);
+}
+
+TransportFactory::TransportFactory(const LoopPoolConfig &config)
+    : loop_pool_(new LoopPool(config.size, config.pin_threads))
+    , loop_policy_(config.policy)
+    , intra_process_view_(std::make_shared<IntraProcessView>())
+    , max_message_size_between_transports_(std::numeric_limits<uint32_t>::max())
+    , min_send_buffer_size_(std::numeric_limits<uint32_t>::max())
+{
+    loop_ = loop_pool_->loop(0);
+    pooled_transports_.resize(loop_pool_->size() - 1);
+
+    open_mailboxes();
+
+    update_intra_process_view(nullptr, 0);
+}
+
+void TransportFactory::open_mailboxes()
+{
+    IntraProcessMailbox::Handler handler = [](
+        ReceiverResource &receiver,
+        const octet *data,
+        uint32_t size,
+        const Locator &source)
+    {
+        receiver.deliver(data, size, receiver.locator(), source, ReceiveMetadata());
+    };
+
+    mailboxes_.resize(loop_pool_ ? loop_pool_->size() : 1);
+    for (size_t i = 0; i < mailboxes_.size(); ++i)
+    {
+        run_on_loop(i, [this, i, &handler]()
+        {
+            mailboxes_[i] = std::make_shared<IntraProcessMailbox>(loop_at(i), handler);
+        });
+    }
 }
 
 TransportFactory::~TransportFactory()
 {
+    std::atomic_store(&intra_process_view_, std::shared_ptr<const IntraProcessView>(
+        std::make_shared<IntraProcessView>()));
+
+    // Channels and transports close their handles on their loops, which must still be running.
+    size_t loops = loop_pool_ ? loop_pool_->size() : 1;
+    for (size_t i = 0; i < loops; ++i)
+    {
+        run_on_loop(i, [this, i]()
+        {
+            close_loop(i);
+        });
+    }
 
+    loop_pool_.reset();
 }
 
-std::shared_ptr<SenderResource> TransportFactory::build_send_resources(
+void TransportFactory::close_loop(
+    size_t loop_index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const OpenedChannel &channel : opened_channels_)
+    {
+        if (channel.loop_index != loop_index)
+        {
+            continue;
+        }
+
+        if (channel.sender)
+        {
+            sender_resource_list.erase(std::remove(sender_resource_list.begin(), sender_resource_list.end(),
+                channel.sender), sender_resource_list.end());
+        }
+        else
+        {
+            receiver_resources_list.erase(std::remove(receiver_resources_list.begin(),
+                receiver_resources_list.end(), channel.receiver), receiver_resources_list.end());
+            local_channels_.erase(channel.receiver->locator());
+        }
+
+        if (loop_pool_)
+        {
+            loop_pool_->release(loop_index);
+        }
+    }
+
+    opened_channels_.erase(std::remove_if(opened_channels_.begin(), opened_channels_.end(), [loop_index](
+                const OpenedChannel &channel)
+    {
+        return channel.loop_index == loop_index;
+    }), opened_channels_.end());
+
+    mailboxes_.at(loop_index)->close();
+
+    if (loop_index == 0)
+    {
+        registered_transports_.clear();
+    }
+    else
+    {
+        pooled_transports_.at(loop_index - 1).clear();
+    }
+}
+
+TransportInterface *TransportFactory::transport_on_loop(
+    int32_t kind,
+    size_t loop_index)
+{
+    auto &transports = loop_index == 0 ? registered_transports_ : pooled_transports_.at(loop_index - 1);
+
+    auto it = std::find_if(transports.begin(), transports.end(), [kind](const auto &transport)
+    {
+        return transport->kind() == kind;
+    });
+
+    return it != transports.end() ? it->get() : nullptr;
+}
+
+void TransportFactory::run_on_loop(
+    size_t loop_index,
+    const std::function<void()> &task)
+{
+    if (loop_pool_)
+    {
+        loop_pool_->run(loop_index, task);
+    }
+    else
+    {
+        task();
+    }
+}
+
+size_t TransportFactory::select_loop(
+    int32_t loop_affinity,
     const Locator &locator)
 {
-    // bool returned_value = false;
+    auto channel = channel_loops_.find(locator);
+    if (channel != channel_loops_.end())
+    {
+        return channel->second;
+    }
 
-    for (auto &transport : registered_transports_)
+    // Reserved before the channel is opened, so that concurrent builders of the locator meet on its loop.
+    size_t loop_index = loop_pool_ ? loop_pool_->select(loop_policy_, loop_affinity) : 0;
+    channel_loops_.emplace(locator, loop_index);
+    return loop_index;
+}
+
+size_t TransportFactory::select_loop_locked(
+    int32_t loop_affinity,
+    const Locator &locator)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return select_loop(loop_affinity, locator);
+}
+
+void TransportFactory::track_sender(
+    size_t loop_index,
+    const std::shared_ptr<SenderResource> &sender)
+{
+    channel_loops_.emplace(sender->locator(), loop_index);
+    sender_resource_list.push_back(sender);
+    opened_channels_.push_back({loop_index, sender, nullptr});
+    if (loop_pool_)
     {
-        if(transport->kind() == locator.kind)
+        loop_pool_->acquire(loop_index);
+    }
+}
+
+void TransportFactory::track_receiver(
+    size_t loop_index,
+    const std::shared_ptr<ReceiverResource> &receiver)
+{
+    channel_loops_.emplace(receiver->locator(), loop_index);
+    receiver_resources_list.push_back(receiver);
+    opened_channels_.push_back({loop_index, nullptr, receiver});
+    if (loop_pool_)
+    {
+        loop_pool_->acquire(loop_index);
+    }
+}
+
+TransportInterface *TransportFactory::transport_on_loop_locked(
+    int32_t kind,
+    size_t loop_index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return transport_on_loop(kind, loop_index);
+}
+
+bool TransportFactory::open_sender_on(
+    TransportInterface &transport,
+    const Locator &locator,
+    size_t loop_index,
+    TrafficPriority priority)
+{
+    bool opened = false;
+    run_on_loop(loop_index, [&]()
+    {
+        // The transport works on a copy of the list: channels of the locator are all opened on this
+        // thread, the ones opened by other loops meanwhile do not matter to it.
+        SendResourceList channels;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            channels = sender_resource_list;
+        }
+
+        size_t list_size = channels.size();
+        opened = transport.open_output_channel(channels, locator, priority);
+
+        // Channels already open are handed out again, they are not accounted twice.
+        if (opened && channels.size() > list_size)
         {
-            transport->open_output_channel(sender_resource_list, locator);
+            std::lock_guard<std::mutex> lock(mutex_);
+            track_sender(loop_index, channels.back());
         }
+    });
+    return opened;
+}
+
+bool TransportFactory::open_receiver_on(
+    TransportInterface &transport,
+    const Locator &locator,
+    uint32_t receiver_max_message_size,
+    size_t loop_index)
+{
+    bool opened = false;
+    run_on_loop(loop_index, [&]()
+    {
+        ReceiverResourceList channels;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            channels = receiver_resources_list;
+        }
+
+        size_t list_size = channels.size();
+        opened = transport.open_input_channel(channels, locator, receiver_max_message_size);
+
+        if (opened && channels.size() > list_size)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            track_receiver(loop_index, channels.back());
+        }
+    });
+    return opened;
+}
+
+std::shared_ptr<uvw::loop> TransportFactory::loop_at(
+    size_t loop_index) const
+{
+    return loop_pool_ ? loop_pool_->loop(loop_index) : loop_;
+}
+
+std::shared_ptr<SenderResource> TransportFactory::build_send_resources(
+    const Locator &locator,
+    int32_t loop_affinity)
+{
+    return build_send_resources_on(locator, select_loop_locked(loop_affinity, locator));
+}
+
+std::shared_ptr<SenderResource> TransportFactory::build_send_resources(
+    const Locator &locator,
+    TrafficPriority priority,
+    int32_t loop_affinity)
+{
+    return build_send_resources_on(locator, select_loop_locked(loop_affinity, locator), priority);
+}
+
+std::shared_ptr<SenderResource> TransportFactory::build_send_resources_on(
+    const Locator &locator,
+    size_t loop_index,
+    TrafficPriority priority)
+{
+    TransportInterface *transport = transport_on_loop_locked(locator.kind, loop_index);
+
+    if (transport)
+    {
+        open_sender_on(*transport, locator, loop_index, priority);
     }
 
-    auto it = std::find_if(sender_resource_list.begin(),sender_resource_list.end(),[&locator](const auto &sender_resource)
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Transports without priority classes hand out their normal channel.
+    auto it = std::find_if(sender_resource_list.begin(),sender_resource_list.end(),[&locator, priority](const auto &sender_resource)
     {
-        return locator == sender_resource->locator();
+        return locator == sender_resource->locator() && priority == sender_resource->priority();
     });
 
-    return it != sender_resource_list.end() ? *it : nullptr;
+    if (it == sender_resource_list.end())
+    {
+        it = std::find_if(sender_resource_list.begin(),sender_resource_list.end(),[&locator](const auto &sender_resource)
+        {
+            return locator == sender_resource->locator();
+        });
+    }
+
+    if (it == sender_resource_list.end())
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<SenderResource> network_sender = *it;
+    TransportInterface *uds_transport = transport_on_loop(LOCATOR_KIND_UDS, loop_index);
+    auto controller = transport_flow_controllers_.find(locator.kind);
+    std::shared_ptr<FlowController> flow_controller =
+            controller != transport_flow_controllers_.end() ? controller->second : nullptr;
+    lock.unlock();
+
+    // UDP destinations on this host are reached through the UDS transport when it is registered.
+    if (uds_transport && (locator.kind == LOCATOR_KIND_UDPv4 || locator.kind == LOCATOR_KIND_UDPv6))
+    {
+        network_sender = std::make_shared<LocalSenderResource>(network_sender,
+                        *static_cast<UDSTransport *>(uds_transport));
+    }
+
+    // Messages delivered in process are not paced.
+    if (flow_controller)
+    {
+        network_sender = flow_controller->attach(network_sender);
+    }
+
+    return std::make_shared<IntraProcessSenderResource>(network_sender, [this](
+                const octet *data,
+                uint32_t size,
+                const Locator &destination,
+                const Locator &source)
+    {
+        return deliver_intra_process(data, size, destination, source);
+    });
+}
+
+bool TransportFactory::select_locator(
+    const LocatorList &peer_locators,
+    Locator &selected) const
+{
+    std::shared_ptr<const IntraProcessView> view = std::atomic_load(&intra_process_view_);
+
+    // SHM and UDS locators carry no host identity, the peer is local when one of its IP
+    // locators is an address of this host, or when it announces no IP locator at all.
+    bool has_ip_locator = false;
+    bool peer_is_local = false;
+    for (const Locator &locator : peer_locators)
+    {
+        if (locator.kind == LOCATOR_KIND_UDPv4 || locator.kind == LOCATOR_KIND_UDPv6 ||
+                locator.kind == LOCATOR_KIND_TCPv4 || locator.kind == LOCATOR_KIND_TCPv6)
+        {
+            has_ip_locator = true;
+            Locator address(locator);
+            address.kind = (locator.kind == LOCATOR_KIND_UDPv4 || locator.kind == LOCATOR_KIND_TCPv4) ?
+                    LOCATOR_KIND_UDPv4 : LOCATOR_KIND_UDPv6;
+            peer_is_local |= !IPLocator::isMulticast(address) && view->is_local_host(address);
+        }
+    }
+    peer_is_local |= !has_ip_locator;
+
+    bool found = false;
+    LocatorCost best_cost = LocatorCost::NETWORK;
+
+    for (const Locator &locator : peer_locators)
+    {
+        auto it = std::find_if(registered_transports_.begin(), registered_transports_.end(), [&locator](const auto &transport)
+        {
+            return transport->is_locator_supported(locator);
+        });
+
+        if (it == registered_transports_.end())
+        {
+            continue;
+        }
+
+        LocatorCost cost = LocatorCost::NETWORK;
+        if (view->find(locator))
+        {
+            cost = LocatorCost::INTRA_PROCESS;
+        }
+        else if (locator.kind == LOCATOR_KIND_SHM || locator.kind == LOCATOR_KIND_UDS)
+        {
+            if (!peer_is_local)
+            {
+                continue;
+            }
+            cost = locator.kind == LOCATOR_KIND_SHM ? LocatorCost::SHARED_MEMORY : LocatorCost::UNIX_DOMAIN;
+        }
+        else if (!IPLocator::isMulticast(locator) && view->is_local_host(locator))
+        {
+            cost = LocatorCost::LOCAL_HOST;
+        }
+
+        if (!found || cost < best_cost)
+        {
+            selected = locator;
+            best_cost = cost;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+std::shared_ptr<SenderResource> TransportFactory::build_send_resources(
+    const LocatorList &peer_locators,
+    Locator &selected,
+    int32_t loop_affinity)
+{
+    if (!select_locator(peer_locators, selected))
+    {
+        return nullptr;
+    }
+
+    // Any address and an ephemeral port: the channel must not collide with a receiver of this process.
+    Locator channel(selected);
+    channel.set_invalid_address();
+    channel.port = 0;
+    return build_send_resources(channel, loop_affinity);
+}
+
+bool TransportFactory::deliver_intra_process(
+    const octet *data,
+    uint32_t size,
+    const Locator &destination,
+    const Locator &source) const
+{
+    std::shared_ptr<const IntraProcessView> view = std::atomic_load(&intra_process_view_);
+
+    const IntraProcessView::Receiver *receiver = view->find(destination);
+    if (!receiver)
+    {
+        return false;
+    }
+
+    // The receiver only runs on the thread of its loop.
+    return receiver->mailbox->post(receiver->resource, data, size, source);
+}
+
+void TransportFactory::update_intra_process_view(
+    const std::shared_ptr<ReceiverResource> &new_receiver,
+    size_t loop_index)
+{
+    std::shared_ptr<const IntraProcessView> current = std::atomic_load(&intra_process_view_);
+    auto view = std::make_shared<IntraProcessView>(*current);
+
+    if (new_receiver)
+    {
+        if (std::any_of(view->receivers.begin(), view->receivers.end(), [&new_receiver](
+                    const IntraProcessView::Receiver &receiver)
+        {
+            return receiver.resource == new_receiver;
+        }))
+        {
+            return;
+        }
+
+        // A channel handed out again keeps the loop it was opened on.
+        auto channel = channel_loops_.find(new_receiver->locator());
+        if (channel != channel_loops_.end())
+        {
+            loop_index = channel->second;
+        }
+        view->receivers.push_back({new_receiver, mailboxes_.at(loop_index)});
+    }
+
+    if (!new_receiver)
+    {
+        IPFinder::getLocalAddresses(&view->addresses);
+    }
+
+    std::atomic_store(&intra_process_view_, std::shared_ptr<const IntraProcessView>(view));
 }
 
 std::shared_ptr<ReceiverResource> TransportFactory::build_receiver_resources(
     Locator &locator,
-    uint32_t receiver_max_message_size)
+    uint32_t receiver_max_message_size,
+    int32_t loop_affinity)
 {
-    for (auto &transport : registered_transports_)
+    return build_receiver_resources_on(locator, receiver_max_message_size, select_loop_locked(loop_affinity, locator));
+}
+
+std::shared_ptr<ReceiverResource> TransportFactory::build_receiver_resources(
+    Locator &locator,
+    uint32_t receiver_max_message_size,
+    TrafficPriority priority,
+    int32_t loop_affinity)
+{
+    return build_receiver_resources_on(locator, receiver_max_message_size, select_loop_locked(loop_affinity, locator),
+                   priority);
+}
+
+std::shared_ptr<ReceiverResource> TransportFactory::build_receiver_resources_on(
+    const Locator &locator,
+    uint32_t receiver_max_message_size,
+    size_t loop_index,
+    TrafficPriority priority)
+{
+    TransportInterface *transport = transport_on_loop_locked(locator.kind, loop_index);
+
+    if (transport && !open_receiver_on(*transport, locator, receiver_max_message_size, loop_index))
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<ReceiverResource> receiver;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(receiver_resources_list.begin(),receiver_resources_list.end(),[&locator](const auto &receiver_resource)
+        {
+            return locator == receiver_resource->locator();
+        });
+
+        if (it == receiver_resources_list.end())
+        {
+            return nullptr;
+        }
+        receiver = *it;
+    }
+
+    // A channel shared by several users keeps the highest priority requested.
+    if (priority != TrafficPriority::NORMAL && receiver->priority() != priority)
+    {
+        run_on_loop(loop_index, [&]()
+        {
+            receiver->set_priority(priority);
+        });
+    }
+
+    if ((locator.kind == LOCATOR_KIND_UDPv4 || locator.kind == LOCATOR_KIND_UDPv6) && !IPLocator::isMulticast(locator))
+    {
+        listen_on_uds(receiver, loop_index);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    update_intra_process_view(receiver, loop_index);
+
+    return receiver;
+}
+
+template<typename Descriptor>
+std::shared_ptr<StaticSenderResource<Descriptor>> TransportFactory::build_static_send_resources(
+    const Locator &locator,
+    int32_t loop_affinity)
+{
+    if (locator.kind != StaticTransportTraits<Descriptor>::kind)
+    {
+        return nullptr;
+    }
+
+    size_t loop_index = select_loop_locked(loop_affinity, locator);
+    TransportInterface *transport = transport_on_loop_locked(locator.kind, loop_index);
+    if (!transport)
+    {
+        return nullptr;
+    }
+
+    // The network sender itself, without the layers build_send_resources puts on top of it.
+    std::shared_ptr<SenderResource> sender;
+    run_on_loop(loop_index, [&]()
+    {
+        SendResourceList channels;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            channels = sender_resource_list;
+        }
+
+        size_t list_size = channels.size();
+        sender = static_cast<typename StaticTransportTraits<Descriptor>::Transport *>(transport)->open_sender(
+            channels, locator, TrafficPriority::NORMAL);
+
+        if (sender && channels.size() > list_size)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            track_sender(loop_index, channels.back());
+        }
+    });
+
+    if (!sender)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<StaticSenderResource<Descriptor>>(new StaticSenderResource<Descriptor>(sender));
+}
+
+template<typename Descriptor>
+std::shared_ptr<StaticReceiverResource<Descriptor>> TransportFactory::build_static_receiver_resources(
+    Locator &local,
+    uint32_t receiver_max_message_size,
+    int32_t loop_affinity)
+{
+    if (local.kind != StaticTransportTraits<Descriptor>::kind)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<ReceiverResource> receiver =
+            build_receiver_resources(local, receiver_max_message_size, loop_affinity);
+    if (!receiver)
+    {
+        return nullptr;
+    }
+
+    return std::shared_ptr<StaticReceiverResource<Descriptor>>(new StaticReceiverResource<Descriptor>(receiver));
+}
+
+template std::shared_ptr<StaticSenderResource<TransportDescriptor<UDPv4Descriptor>>>
+TransportFactory::build_static_send_resources<TransportDescriptor<UDPv4Descriptor>>(
+    const Locator &,
+    int32_t);
+template std::shared_ptr<StaticSenderResource<TransportDescriptor<UDPv6Descriptor>>>
+TransportFactory::build_static_send_resources<TransportDescriptor<UDPv6Descriptor>>(
+    const Locator &,
+    int32_t);
+template std::shared_ptr<StaticReceiverResource<TransportDescriptor<UDPv4Descriptor>>>
+TransportFactory::build_static_receiver_resources<TransportDescriptor<UDPv4Descriptor>>(
+    Locator &,
+    uint32_t,
+    int32_t);
+template std::shared_ptr<StaticReceiverResource<TransportDescriptor<UDPv6Descriptor>>>
+TransportFactory::build_static_receiver_resources<TransportDescriptor<UDPv6Descriptor>>(
+    Locator &,
+    uint32_t,
+    int32_t);
+
+std::shared_ptr<SenderResource> TransportFactory::build_channel_send_resources(
+    const Locator &locator,
+    uint32_t channel_id,
+    int32_t loop_affinity)
+{
+    std::shared_ptr<SenderResource> network_sender = build_send_resources(locator, loop_affinity);
+    if (!network_sender)
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<ChannelSenderResource>(network_sender, channel_id);
+}
+
+std::shared_ptr<ReceiverResource> TransportFactory::build_channel_receiver_resources(
+    Locator &local,
+    uint32_t channel_id,
+    uint32_t receiver_max_message_size,
+    int32_t loop_affinity)
+{
+    std::shared_ptr<ReceiverResource> network_receiver =
+            build_receiver_resources(local, with_header(receiver_max_message_size, s_channelHeaderSize),
+                loop_affinity);
+    if (!network_receiver)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<ChannelDemultiplexer> demultiplexer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &entry = demultiplexers_[network_receiver->locator()];
+        if (!entry)
+        {
+            entry = std::make_shared<ChannelDemultiplexer>();
+            std::shared_ptr<ChannelDemultiplexer> table = entry;
+
+            // The plain callback, so that the shared socket does not timestamp every datagram for channels
+            // that never look at the metadata.
+            network_receiver->register_receiver([table](const unsigned char* data,
+                                        const uint32_t size,
+                                        const Locator& local_locator,
+                                        const Locator& remote_locator)
+            {
+                table->dispatch(data, size, local_locator, remote_locator, ReceiveMetadata());
+            });
+        }
+        demultiplexer = entry;
+    }
+
+    return demultiplexer->channel(network_receiver, channel_id);
+}
+
+std::shared_ptr<SenderResource> TransportFactory::build_reliable_send_resources(
+    const Locator &locator,
+    const ReliabilityConfig &config,
+    int32_t loop_affinity)
+{
+    if (locator.port == 0 || IPLocator::isMulticast(locator))
+    {
+        return nullptr;
+    }
+
+    size_t loop_index = select_loop_locked(loop_affinity, locator);
+
+    std::shared_ptr<SenderResource> network_sender = build_send_resources_on(locator, loop_index);
+    if (!network_sender)
+    {
+        return nullptr;
+    }
+
+    // Reading the socket of the channel gets the NACKs of the readers.
+    std::shared_ptr<ReceiverResource> control_receiver =
+            build_receiver_resources_on(locator, s_reliableControlSize, loop_index);
+    if (!control_receiver)
+    {
+        return nullptr;
+    }
+
+    auto sender = std::make_shared<ReliableSenderResource>(network_sender, config);
+    std::weak_ptr<ReliableSenderResource> weak_sender = sender;
+
+    control_receiver->register_receiver([weak_sender](const unsigned char* data,
+                                const uint32_t size,
+                                const Locator& ,
+                                const Locator& remote_locator)
     {
-        if(transport->kind() == locator.kind)
+        if (auto reliable_sender = weak_sender.lock())
         {
-            if(!transport->open_input_channel(receiver_resources_list, locator, receiver_max_message_size))
+            reliable_sender->on_control(data, size, remote_locator);
+        }
+    });
+
+    std::shared_ptr<uvw::loop> loop = loop_at(loop_index);
+    run_on_loop(loop_index, [&]()
+    {
+        auto timer = loop->resource<uvw::timer_handle>();
+        timer->on<uvw::timer_event>([weak_sender](const uvw::timer_event &, uvw::timer_handle &)
+        {
+            if (auto reliable_sender = weak_sender.lock())
             {
-                return nullptr;
+                reliable_sender->send_heartbeat();
             }
-            break;
+        });
+        timer->start(config.heartbeat_period, config.heartbeat_period);
+
+        // The sender wakes this handle up when destroyed, from any thread, which closes both handles.
+        auto wakeup = loop->resource<uvw::async_handle>();
+        wakeup->on<uvw::async_event>([timer](const uvw::async_event &, uvw::async_handle &handle)
+        {
+            timer->stop();
+            timer->close();
+            handle.close();
+        });
+        wakeup->unreference();
+
+        sender->stop_heartbeat_ = [wakeup]()
+        {
+            wakeup->send();
+        };
+    });
+
+    return sender;
+}
+
+std::shared_ptr<ReceiverResource> TransportFactory::build_reliable_receiver_resources(
+    Locator &local,
+    uint32_t receiver_max_message_size,
+    const ReliabilityConfig &config,
+    int32_t loop_affinity)
+{
+    size_t loop_index = select_loop_locked(loop_affinity, local);
+
+    std::shared_ptr<ReceiverResource> network_receiver =
+            build_receiver_resources_on(local, with_header(receiver_max_message_size, s_reliableHeaderSize),
+                loop_index);
+    if (!network_receiver)
+    {
+        return nullptr;
+    }
+
+    // NACKs leave from the socket of the reader, so that retransmissions come back to it.
+    // Multicast readers listen on a socket bound to the wildcard address.
+    Locator nack_channel(local);
+    if (IPLocator::isMulticast(nack_channel))
+    {
+        nack_channel.set_invalid_address();
+    }
+
+    std::shared_ptr<SenderResource> nack_sender = build_send_resources_on(nack_channel, loop_index);
+    if (!nack_sender)
+    {
+        return nullptr;
+    }
+
+    auto receiver = std::make_shared<ReliableReceiverResource>(network_receiver, nack_sender, config);
+    std::weak_ptr<ReliableReceiverResource> weak_receiver = receiver;
+
+    network_receiver->register_receiver([weak_receiver](const unsigned char* data,
+                                const uint32_t size,
+                                const Locator& local_locator,
+                                const Locator& remote_locator,
+                                const ReceiveMetadata& metadata)
+    {
+        if (auto reliable_receiver = weak_receiver.lock())
+        {
+            reliable_receiver->on_message(data, size, local_locator, remote_locator, metadata);
         }
+    });
+
+    return receiver;
+}
+
+std::shared_ptr<FlowController> TransportFactory::create_flow_controller(
+    const FlowControllerConfig &config)
+{
+    auto controller = std::make_shared<FlowController>(config);
+    std::weak_ptr<FlowController> weak_controller = controller;
+
+    run_on_loop(0, [&]()
+    {
+        auto timer = loop_->resource<uvw::timer_handle>();
+        timer->on<uvw::timer_event>([weak_controller](const uvw::timer_event &, uvw::timer_handle &handle)
+        {
+            auto flow_controller = weak_controller.lock();
+            if (!flow_controller || !flow_controller->on_timer())
+            {
+                handle.stop();
+            }
+        });
+
+        // Senders start the timer from their threads when they queue a message. The controller also
+        // wakes it up when destroyed, which closes both handles.
+        auto wakeup = loop_->resource<uvw::async_handle>();
+        wakeup->on<uvw::async_event>([weak_controller, timer, period = config.period](const uvw::async_event &,
+                uvw::async_handle &handle)
+        {
+            if (weak_controller.expired())
+            {
+                timer->close();
+                handle.close();
+            }
+            else if (!timer->active())
+            {
+                timer->start(period, period);
+            }
+        });
+        wakeup->unreference();
+
+        controller->start_timer_ = [wakeup]()
+        {
+            wakeup->send();
+        };
+    });
+
+    return controller;
+}
+
+void TransportFactory::listen_on_uds(
+    const std::shared_ptr<ReceiverResource> &receiver,
+    size_t loop_index)
+{
+    UDSTransport *uds_transport = static_cast<UDSTransport *>(transport_on_loop_locked(LOCATOR_KIND_UDS, loop_index));
+    if (!uds_transport)
+    {
+        return;
     }
-    auto it = std::find_if(receiver_resources_list.begin(),receiver_resources_list.end(),[&locator](const auto &receiver_resource)
+
+    // Every channel of the locator runs on this loop, checking and opening there is not raced.
+    std::shared_ptr<ReceiverResource> local_receiver;
+    run_on_loop(loop_index, [&]()
     {
-        return locator == receiver_resource->locator();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (local_channels_.count(receiver->locator()) > 0)
+            {
+                return;
+            }
+        }
+
+        local_receiver = uds_transport->open_local_channel(receiver->locator(), receiver->max_message_size());
+
+        // The name may already be taken by another process, the channel is then only reachable through UDP.
+        if (local_receiver)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            local_channels_.insert(receiver->locator());
+            opened_channels_.push_back({loop_index, nullptr, local_receiver});
+            if (loop_pool_)
+            {
+                loop_pool_->acquire(loop_index);
+            }
+        }
     });
 
-    return it != receiver_resources_list.end() ? *it : nullptr;
+    if (!local_receiver)
+    {
+        return;
+    }
+
+    // Datagrams received through the local channel are delivered as if they came through UDP,
+    // from the UDP locator of the sending channel.
+    std::weak_ptr<ReceiverResource> weak_receiver = receiver;
+    local_receiver->register_receiver([weak_receiver](const unsigned char* data,
+                                const uint32_t size,
+                                const Locator& ,
+                                const Locator& remote_locator,
+                                const ReceiveMetadata& metadata)
+    {
+        if (auto network_receiver = weak_receiver.lock())
+        {
+            network_receiver->deliver(data, size, network_receiver->locator(), remote_locator, metadata);
+        }
+    });
 }
 
 bool TransportFactory::register_transport(
@@ -88,14 +1026,20 @@ bool TransportFactory::register_transport(
 {
     bool wasRegistered = false;
 
-    auto it = std::find_if(registered_transports_.begin(),registered_transports_.end(),[descriptor](const auto &transport)
+    auto is_registered = [this, descriptor]()
     {
-        return descriptor->transport_kind() == transport->kind();
-    });
+        return std::any_of(registered_transports_.begin(),registered_transports_.end(),[descriptor](const auto &transport)
+        {
+            return descriptor->transport_kind() == transport->kind();
+        });
+    };
 
-    if(it != registered_transports_.end())
     {
-        return true;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (is_registered())
+        {
+            return true;
+        }
     }
 
     uint32_t minSendBufferSize = std::numeric_limits<uint32_t>::max();
@@ -104,24 +1048,88 @@ bool TransportFactory::register_transport(
 
     if (transport)
     {
-        if (transport->init())
+        // Transports are initialized on their loops, lazily initialized ones queue work there.
+        run_on_loop(0, [&]()
         {
-            // minSendBufferSize = transport->get_configuration()->min_send_buffer_size();
-            registered_transports_.emplace_back(std::move(transport));
-            wasRegistered = true;
-        }
+            wasRegistered = transport->init();
+        });
 
-        if (wasRegistered)
+        // Every other loop of the pool gets its own instance of the transport. Channels may be assigned to
+        // any loop, so the transport is only registered when all of them are ready.
+        std::vector<std::unique_ptr<TransportInterface>> pooled(pooled_transports_.size());
+        for (size_t i = 0; wasRegistered && i < pooled.size(); ++i)
         {
-            if (descriptor->max_message_size() < max_message_size_between_transports_)
+            run_on_loop(i + 1, [&]()
             {
-                max_message_size_between_transports_ = descriptor->max_message_size();
-            }
+                pooled[i].reset(descriptor->create_transport(loop_pool_->loop(i + 1)));
+                wasRegistered = pooled[i] && pooled[i]->init();
+            });
+        }
 
-            if (minSendBufferSize < min_send_buffer_size_)
+        // Instances are destroyed on their loops, where their handles live.
+        auto discard = [&]()
+        {
+            for (size_t i = 0; i < pooled.size(); ++i)
             {
-                min_send_buffer_size_ = minSendBufferSize;
+                run_on_loop(i + 1, [&]()
+                {
+                    pooled[i].reset();
+                });
             }
+            run_on_loop(0, [&]()
+            {
+                transport.reset();
+            });
+        };
+
+        if (!wasRegistered)
+        {
+            discard();
+            return false;
+        }
+
+        std::shared_ptr<FlowController> flow_controller;
+        if (descriptor->max_bytes_per_second_ > 0)
+        {
+            FlowControllerConfig config;
+            config.bytes_per_second = descriptor->max_bytes_per_second_;
+            config.burst_size = descriptor->max_burst_size_;
+            flow_controller = create_flow_controller(config);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // Registered by another thread meanwhile.
+        if (is_registered())
+        {
+            lock.unlock();
+            discard();
+            return true;
+        }
+
+        // Transports without a configuration of their own use the one they were created from.
+        TransportDescriptorInterface *configuration = transport->get_configuration();
+        minSendBufferSize = configuration ? configuration->min_send_buffer_size() :
+                descriptor->min_send_buffer_size();
+        registered_transports_.emplace_back(std::move(transport));
+        for (size_t i = 0; i < pooled.size(); ++i)
+        {
+            pooled_transports_[i].emplace_back(std::move(pooled[i]));
+        }
+
+        if (flow_controller)
+        {
+            transport_flow_controllers_[descriptor->transport_kind()] = flow_controller;
+        }
+
+        if (descriptor->max_message_size() < max_message_size_between_transports_)
+        {
+            max_message_size_between_transports_ = descriptor->max_message_size();
+        }
+
+        if (minSendBufferSize < min_send_buffer_size_)
+        {
+            min_send_buffer_size_ = minSendBufferSize;
         }
     }
 
@@ -239,15 +1247,142 @@ void TransportFactory::shutdown()
     {
         transport->shutdown();
     }
+
+    for (auto &transports : pooled_transports_)
+    {
+        for (auto &transport : transports)
+        {
+            transport->shutdown();
+        }
+    }
 }
 
 
 void TransportFactory::update_network_interfaces()
 {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        update_intra_process_view(nullptr, 0);
+    }
+
     for (auto &transport : registered_transports_)
     {
         transport->update_network_interfaces();
     }
+
+    for (auto &transports : pooled_transports_)
+    {
+        for (auto &transport : transports)
+        {
+            transport->update_network_interfaces();
+        }
+    }
+}
+
+bool TransportFactory::export_sockets(
+    const std::string &path,
+    std::chrono::milliseconds timeout)
+{
+    std::vector<HandoffSocket> sockets;
+    std::vector<std::shared_ptr<ReceiverResource>> exported_receivers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto add = [&sockets](const Locator &locator, bool input, TrafficPriority priority, int fd)
+        {
+            // Receivers and normal senders of the same locator share their socket, it is sent once.
+            if (fd < 0 || std::any_of(sockets.begin(), sockets.end(), [fd](const HandoffSocket &socket)
+            {
+                return socket.fd == fd;
+            }))
+            {
+                return;
+            }
+
+            HandoffSocket socket;
+            socket.locator = locator;
+            socket.input = input;
+            socket.priority = priority;
+            socket.fd = fd;
+            sockets.push_back(socket);
+        };
+
+        for (auto &receiver : receiver_resources_list)
+        {
+            add(receiver->locator(), true, receiver->priority(), receiver->native_handle());
+            if (receiver->native_handle() >= 0)
+            {
+                exported_receivers.push_back(receiver);
+            }
+        }
+
+        for (auto &sender : sender_resource_list)
+        {
+            add(sender->locator(), false, sender->priority(), sender->native_handle());
+        }
+    }
+
+    if (!SocketHandoff::send(path, sockets, timeout))
+    {
+        return false;
+    }
+
+    // The datagrams queued in the sockets from now on belong to the adopting process.
+    for (auto &receiver : exported_receivers)
+    {
+        size_t loop_index = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto channel = channel_loops_.find(receiver->locator());
+            if (channel != channel_loops_.end())
+            {
+                loop_index = channel->second;
+            }
+        }
+
+        run_on_loop(loop_index, [&receiver]()
+        {
+            receiver->stop_reading();
+        });
+    }
+
+    return true;
+}
+
+bool TransportFactory::adopt_sockets(
+    const std::string &path,
+    std::chrono::milliseconds timeout)
+{
+    std::vector<HandoffSocket> sockets;
+    if (!SocketHandoff::receive(path, sockets, timeout))
+    {
+        return false;
+    }
+
+    bool adopted_all = true;
+    for (const HandoffSocket &socket : sockets)
+    {
+        // The channels later built for the locator are opened on the loop owning its socket.
+        size_t loop_index = select_loop_locked(-1, socket.locator);
+        TransportInterface *transport = transport_on_loop_locked(socket.locator.kind, loop_index);
+
+        bool adopted = false;
+        if (transport)
+        {
+            run_on_loop(loop_index, [&]()
+            {
+                adopted = transport->adopt_socket(socket);
+            });
+        }
+
+        if (!adopted)
+        {
+            ::close(socket.fd);
+            adopted_all = false;
+        }
+    }
+
+    return adopted_all;
 }
 
 } // namespace transport
@@ -15,10 +15,23 @@
 #include "UDPReceiverResource.h"
 #include "UDPTransportInterface.h"
 #include "IPLocator.h"
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#include <linux/sock_diag.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif // if defined(__linux__)
 
 namespace transport
 {
 
+//! Maximum number of datagrams read in a single readable event, so one busy socket cannot starve the loop.
+constexpr uint32_t s_maxDatagramsPerEvent = 64;
+
 UDPReceiverResource::UDPReceiverResource(
     UDPTransportInterface *transport,
     std::shared_ptr<uvw::udp_handle> socket,
@@ -26,35 +39,287 @@ UDPReceiverResource::UDPReceiverResource(
     const Locator &locator)
     : ReceiverResource(locator, maxMsgSize)
     , alive_(true)
-    , callback_(nullptr)
+    , read_pending_(false)
     , transport_(transport)
+    , socket_(socket)
+    , poll_(nullptr)
+    , poll_fd_(-1)
+    , kernel_drops_(0)
+    , truncated_drops_(0)
 {
-    socket->on<uvw::udp_data_event>([&](const uvw::udp_data_event &event, uvw::udp_handle &){
-        if(callback_)
+#if !defined(__linux__)
+    socket->on<uvw::udp_data_event>([this](const uvw::udp_data_event &event, uvw::udp_handle &){
+        if (event.partial)
         {
-            Locator remote_locator;
-            IPLocator::createLocator(transport_->kind(),
-                event.sender.ip, event.sender.port,remote_locator);
-
-            callback_(reinterpret_cast<unsigned char*>(event.data.get()),
-                    event.length, locator, remote_locator);
+            truncated_drops_.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
+
+        Locator remote_locator;
+        IPLocator::createLocator(transport_->kind(),
+            event.sender.ip, event.sender.port,remote_locator);
+
+        deliver(reinterpret_cast<unsigned char*>(event.data.get()),
+                event.length, locator_, remote_locator, ReceiveMetadata());
     });
+#endif // if !defined(__linux__)
 
-    locator_check_callback_ = [&](const Locator &locatorToCheck) -> bool
+    locator_check_callback_ = [this](const Locator &locatorToCheck) -> bool
     {
-        return locator.kind == locatorToCheck.kind && transport_->do_input_locators_match(locator, locatorToCheck);
+        return locator_.kind == locatorToCheck.kind && transport_->do_input_locators_match(locator_, locatorToCheck);
     };
 }
 
 UDPReceiverResource::~UDPReceiverResource()
 {
+    if (read_pending_)
+    {
+        transport_->cancel_read(this);
+    }
+    if (poll_)
+    {
+        poll_->stop();
+        poll_->close();
+    }
+#if defined(__linux__)
+    if (poll_fd_ >= 0)
+    {
+        ::close(poll_fd_);
+    }
+#endif // if defined(__linux__)
 }
 
 void UDPReceiverResource::register_receiver(
     const Callback &callback)
 {
-    callback_ = callback;
+    recv_callback_ = callback;
+}
+
+void UDPReceiverResource::register_receiver(
+    const MetadataReceiveCallback &callback)
+{
+    ReceiverResource::register_receiver(callback);
+    if (metadata_callback_)
+    {
+        enable_timestamps();
+    }
+}
+
+void UDPReceiverResource::enable_timestamps()
+{
+#if defined(__linux__)
+    int fd = static_cast<int>(socket_->fd());
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+            SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+    {
+        int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    }
+#endif // if defined(__linux__)
+}
+
+void UDPReceiverResource::start()
+{
+#if defined(__linux__)
+    int fd = static_cast<int>(socket_->fd());
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+    if (locator_.kind == LOCATOR_KIND_UDPv6)
+    {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enable, sizeof(enable));
+    }
+    else
+    {
+        setsockopt(fd, IPPROTO_IP, IP_PKTINFO, &enable, sizeof(enable));
+    }
+
+    poll_fd_ = ::dup(fd);
+    if (poll_fd_ < 0)
+    {
+        return;
+    }
+
+    buffer_.resize(max_message_size_);
+    poll_ = transport_->loop_->resource<uvw::poll_handle>(poll_fd_);
+    poll_->on<uvw::poll_event>([this](const uvw::poll_event &, uvw::poll_handle &)
+    {
+        if (priority_ == TrafficPriority::HIGH)
+        {
+            on_readable();
+        }
+        else
+        {
+            transport_->schedule_read(this);
+        }
+    });
+    poll_->start(uvw::poll_handle::poll_event_flags::READABLE);
+#else
+    socket_->recv();
+#endif // if defined(__linux__)
+}
+
+void UDPReceiverResource::stop_reading()
+{
+    if (read_pending_)
+    {
+        transport_->cancel_read(this);
+        read_pending_ = false;
+    }
+#if defined(__linux__)
+    if (poll_)
+    {
+        poll_->stop();
+    }
+#else
+    socket_->stop();
+#endif // if defined(__linux__)
+}
+
+void UDPReceiverResource::set_priority(
+    TrafficPriority priority)
+{
+    ReceiverResource::set_priority(priority);
+    if (priority == TrafficPriority::HIGH)
+    {
+        transport_->configure_priority(socket_);
+    }
+}
+
+void UDPReceiverResource::on_readable()
+{
+#if defined(__linux__)
+    // Room for the SO_RXQ_OVFL counter, the SO_TIMESTAMPING timestamps and the packet info.
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(scm_timestamping)) +
+            CMSG_SPACE(sizeof(in6_pktinfo))];
+    sockaddr_storage remote_address;
+    iovec iov;
+    msghdr msg;
+
+    for (uint32_t i = 0; i < s_maxDatagramsPerEvent; ++i)
+    {
+        iov.iov_base = buffer_.data();
+        iov.iov_len = buffer_.size();
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &remote_address;
+        msg.msg_namelen = sizeof(remote_address);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t received = ::recvmsg(poll_fd_, &msg, MSG_DONTWAIT);
+        if (received < 0)
+        {
+            // EAGAIN means the queue has been drained.
+            break;
+        }
+
+        ReceiveMetadata metadata;
+        Locator local_locator(locator_);
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO)
+            {
+                // ipi_addr is the destination address of the header, the group for multicast datagrams.
+                in_pktinfo info;
+                memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+                IPLocator::setIPv4(local_locator, reinterpret_cast<const unsigned char *>(&info.ipi_addr));
+                metadata.interface_index = static_cast<uint32_t>(info.ipi_ifindex);
+                continue;
+            }
+
+            if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO)
+            {
+                in6_pktinfo info;
+                memcpy(&info, CMSG_DATA(cmsg), sizeof(info));
+                IPLocator::setIPv6(local_locator, reinterpret_cast<const unsigned char *>(&info.ipi6_addr));
+                metadata.interface_index = static_cast<uint32_t>(info.ipi6_ifindex);
+                continue;
+            }
+
+            if (cmsg->cmsg_level != SOL_SOCKET)
+            {
+                continue;
+            }
+
+            if (cmsg->cmsg_type == SCM_TIMESTAMPING)
+            {
+                // ts[0] holds the software timestamp and ts[2] the raw hardware one.
+                scm_timestamping timestamps;
+                memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(timestamps));
+                metadata.kernel_timestamp = std::chrono::seconds(timestamps.ts[0].tv_sec) +
+                        std::chrono::nanoseconds(timestamps.ts[0].tv_nsec);
+                metadata.hardware_timestamp = std::chrono::seconds(timestamps.ts[2].tv_sec) +
+                        std::chrono::nanoseconds(timestamps.ts[2].tv_nsec);
+            }
+            else if (cmsg->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                timespec timestamp;
+                memcpy(&timestamp, CMSG_DATA(cmsg), sizeof(timestamp));
+                metadata.kernel_timestamp = std::chrono::seconds(timestamp.tv_sec) +
+                        std::chrono::nanoseconds(timestamp.tv_nsec);
+            }
+            else if (cmsg->cmsg_type == SO_RXQ_OVFL)
+            {
+                uint32_t drops;
+                memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                if (drops != kernel_drops_.exchange(drops, std::memory_order_relaxed))
+                {
+                    transport_->grow_receive_buffer(socket_);
+                }
+            }
+        }
+
+        // The rest of the datagram is lost, delivering the head would hand out a corrupted message.
+        if (msg.msg_flags & MSG_TRUNC)
+        {
+            truncated_drops_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        Locator remote_locator;
+        IPLocator::createLocator(transport_->kind(),
+            reinterpret_cast<const sockaddr *>(&remote_address), remote_locator);
+
+        deliver(buffer_.data(), static_cast<uint32_t>(received), local_locator, remote_locator, metadata);
+    }
+#endif // if defined(__linux__)
+}
+
+ReceiverStatistics UDPReceiverResource::statistics() const
+{
+    ReceiverStatistics stats = ReceiverResource::statistics();
+    stats.kernel_drops = kernel_drops_.load(std::memory_order_relaxed);
+    stats.truncated_drops = truncated_drops_.load(std::memory_order_relaxed);
+#if defined(__linux__)
+    int fd = static_cast<int>(socket_->fd());
+
+#if defined(SO_MEMINFO)
+    // SIOCINQ only reports the first datagram of an UDP socket, the memory info gives the whole backlog.
+    uint32_t meminfo[SK_MEMINFO_VARS];
+    socklen_t len = sizeof(meminfo);
+    if (getsockopt(fd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) == 0)
+    {
+        stats.queued_bytes = meminfo[SK_MEMINFO_RMEM_ALLOC];
+        stats.buffer_size = meminfo[SK_MEMINFO_RCVBUF];
+        return stats;
+    }
+#endif // if defined(SO_MEMINFO)
+
+    int queued = 0;
+    if (ioctl(fd, SIOCINQ, &queued) == 0)
+    {
+        stats.queued_bytes = static_cast<uint32_t>(queued);
+    }
+    stats.buffer_size = static_cast<uint32_t>(socket_->recv_buffer_size());
+#endif // if defined(__linux__)
+    return stats;
+}
+
+int UDPReceiverResource::native_handle() const
+{
+    return static_cast<int>(socket_->fd());
 }
 
 } // namespace transport
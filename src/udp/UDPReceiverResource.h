@@ -19,22 +19,26 @@
 #include <transport/type.h>
 #include <transport/ReceiverResource.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace uvw
 {
     class udp_handle;
+    class poll_handle;
 }
 
 namespace transport
 {
 class UDPTransportInterface;
 
-using Callback = std::function<void(const unsigned char* data,
-                                    const uint32_t size,
-                                    const Locator& local_locator,
-                                    const Locator& remote_locator)>;
+using Callback = ReceiveCallback;
 
 class UDPReceiverResource : public ReceiverResource
 {
+    friend class UDPTransportInterface;
+
 public:
     UDPReceiverResource(
         UDPTransportInterface *transport,
@@ -45,12 +49,63 @@ public:
     virtual ~UDPReceiverResource();
 
     void register_receiver(
-        const Callback &callback);
+        const Callback &callback) override;
+
+    /**
+     * Registers a callback receiving the kernel (and, when enabled on the NIC, hardware) receive
+     * timestamp of every datagram. Timestamping is only requested to the kernel from this point on.
+     */
+    void register_receiver(
+        const MetadataReceiveCallback &callback) override;
+
+    /**
+     * Starts reading from the socket. Must be called once the socket is bound.
+     * On Linux the socket is read with recvmsg so that the kernel drop counter (SO_RXQ_OVFL)
+     * can be collected along with every datagram, as well as its destination address and the interface
+     * it arrived on (IP_PKTINFO / IPV6_RECVPKTINFO). The destination address is reported as the
+     * local locator, so a socket bound to the wildcard address tells which address was reached.
+     */
+    void start();
+
+    /**
+     * High priority receivers are read as soon as their socket is reported readable, the normal ones
+     * once every readable socket of the loop iteration has been reported.
+     * The socket is also marked, as it is shared with the senders bound to the same locator.
+     */
+    void set_priority(
+        TrafficPriority priority) override;
+
+    ReceiverStatistics statistics() const override;
+
+    int native_handle() const override;
+
+    void stop_reading() override;
 
 private:
+    //! Drains the datagrams currently queued in the socket.
+    void on_readable();
+
+    //! Asks the kernel to timestamp received datagrams.
+    void enable_timestamps();
+
     bool alive_;
-    Callback callback_;
+    //! Whether the receiver is waiting in the pending reads of the transport.
+    bool read_pending_;
     UDPTransportInterface *transport_;
+    std::shared_ptr<uvw::udp_handle> socket_;
+
+    //! Watches a duplicate of the socket descriptor, libuv only allows one watcher per descriptor.
+    std::shared_ptr<uvw::poll_handle> poll_;
+    int poll_fd_;
+
+    //! Reception buffer, sized to the maximum message size.
+    std::vector<octet> buffer_;
+
+    //! Last value of the kernel drop counter received along with a datagram.
+    std::atomic<uint32_t> kernel_drops_;
+
+    //! Datagrams larger than the reception buffer, which the kernel cut short.
+    std::atomic<uint32_t> truncated_drops_;
 
     UDPReceiverResource(
         const UDPReceiverResource &) = delete;
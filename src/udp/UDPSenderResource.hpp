@@ -19,24 +19,30 @@
 #include <transport/type.h>
 #include <transport/SenderResource.h>
 #include "UDPTransportInterface.h"
+#include "ZeroCopySocket.h"
 
 namespace transport
 {
 
 class UDPSenderResource : public SenderResource
 {
+    friend class UDPTransportInterface;
+
 public:
     UDPSenderResource(
         const Locator &locator,
         UDPTransportInterface &transport,
         std::shared_ptr<uvw::udp_handle> socket,
         bool only_multicast_purpose = false,
-        bool whitelisted = false)
+        bool whitelisted = false,
+        TrafficPriority priority = TrafficPriority::NORMAL)
     : SenderResource()
     , locator_(locator)
+    , priority_(priority)
     , only_multicast_purpose_(only_multicast_purpose)
     , whitelisted_(whitelisted)
     , transport_(transport)
+    , socket_(socket)
     {
         send_lambda_ = [this, socket, &transport](
                             const octet *data,
@@ -54,6 +60,52 @@ public:
         return locator_;
     }
 
+    using SenderResource::send;
+
+    //! Messages reaching the zero-copy threshold of the transport are sent without copying them.
+    virtual bool send(
+        const octet *data,
+        uint32_t dataLength,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback &release) override
+    {
+        if (zerocopy_ && dataLength >= transport_.zerocopy_threshold_)
+        {
+            return transport_.send(data, dataLength, socket_, locators, only_multicast_purpose_, whitelisted_,
+                                   max_blocking_time_point, *zerocopy_, release);
+        }
+
+        return SenderResource::send(data, dataLength, locators, max_blocking_time_point, release);
+    }
+
+    //! Sends through the transport with a direct call, for StaticSenderResource.
+    bool send_direct(
+        const octet *data,
+        uint32_t dataLength,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point)
+    {
+        return transport_.UDPTransportInterface::send(data, dataLength, socket_, locators, only_multicast_purpose_,
+                                                     whitelisted_, max_blocking_time_point);
+    }
+
+    virtual bool set_multicast_loopback(
+        bool enable) override
+    {
+        return socket_->multicast_loop(enable);
+    }
+
+    virtual TrafficPriority priority() const final
+    {
+        return priority_;
+    }
+
+    virtual int native_handle() const override
+    {
+        return static_cast<int>(socket_->fd());
+    }
+
     virtual ~UDPSenderResource()
     {
     }
@@ -68,9 +120,13 @@ private:
         const SenderResource &) = delete;
 
     Locator locator_;
+    TrafficPriority priority_;
     bool only_multicast_purpose_;
     bool whitelisted_;
     UDPTransportInterface &transport_;
+    std::shared_ptr<uvw::udp_handle> socket_;
+    //! Sibling socket for zero-copy sends, nullptr when they are disabled or unsupported.
+    std::shared_ptr<ZeroCopySocket> zerocopy_;
 };
 
 } // namespace transport
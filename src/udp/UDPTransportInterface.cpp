@@ -21,11 +21,161 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <climits>
+#include <cstdint>
+#if defined(__linux__)
+#include <linux/net_tstamp.h>
+#endif // if defined(__linux__)
+#include <transport/TransportDescriptorInterface.h>
 #include "UDPSenderResource.hpp"
+#include "ZeroCopySocket.h"
 
 namespace transport
 {
 
+//! Sends a destination takes before getting a connected socket.
+constexpr uint32_t s_hotDestinationSends = 8;
+
+struct UDPTransportInterface::InterfaceDiscovery
+{
+    //! Held while the enumeration runs, so that the transport waits for it before going away.
+    std::mutex mutex;
+    //! Reset by the transport when it goes away.
+    UDPTransportInterface *transport;
+};
+
+struct UDPTransportInterface::ConnectedSocket
+{
+    explicit ConnectedSocket(
+        int descriptor)
+        : fd(descriptor)
+        , used(false)
+    {
+    }
+
+    ~ConnectedSocket()
+    {
+        ::close(fd);
+    }
+
+    int fd;
+    //! Set by the sends, cleared by the eviction, which spares the sockets used since its last pass.
+    std::atomic<bool> used;
+};
+
+struct UDPTransportInterface::SocketState
+{
+    using ConnectedSockets = std::map<Locator, std::shared_ptr<ConnectedSocket>>;
+
+    //! Whether a receiver reads the socket, whose datagrams must then keep its source port.
+    std::atomic<bool> read{false};
+    //! Connected sockets by destination, replaced as a whole under connected_mutex_.
+    std::shared_ptr<const ConnectedSockets> connected = std::make_shared<const ConnectedSockets>();
+    //! Sends to destinations without a connected socket yet. Guarded by connected_mutex_.
+    std::map<Locator, uint32_t> cold_sends;
+};
+
+/**
+ * Opens a socket on the address of a shared socket, with an ephemeral port.
+ * The marking, the hop limits, the multicast settings and the send buffer of the shared socket are
+ * carried over.
+ * @return The descriptor, -1 on failure.
+ */
+static int open_sibling_socket(
+    int shared_fd)
+{
+#if defined(__linux__)
+    sockaddr_storage local;
+    socklen_t local_length = sizeof(local);
+    if (getsockname(shared_fd, reinterpret_cast<sockaddr *>(&local), &local_length) != 0)
+    {
+        return -1;
+    }
+
+    if (local.ss_family == AF_INET)
+    {
+        reinterpret_cast<sockaddr_in &>(local).sin_port = 0;
+    }
+    else
+    {
+        reinterpret_cast<sockaddr_in6 &>(local).sin6_port = 0;
+    }
+
+    int fd = ::socket(local.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    // Integer options, IP_MULTICAST_LOOP and IP_MULTICAST_TTL are read back as such on Linux.
+    static const int ipv4_options[] = {IP_TOS, IP_TTL, IP_MULTICAST_LOOP, IP_MULTICAST_TTL};
+    static const int ipv6_options[] = {IPV6_TCLASS, IPV6_UNICAST_HOPS, IPV6_MULTICAST_LOOP, IPV6_MULTICAST_HOPS,
+                                       IPV6_MULTICAST_IF};
+
+    int value;
+    socklen_t value_length = sizeof(value);
+    if (local.ss_family == AF_INET)
+    {
+        for (int option : ipv4_options)
+        {
+            value_length = sizeof(value);
+            if (getsockopt(shared_fd, IPPROTO_IP, option, &value, &value_length) == 0)
+            {
+                setsockopt(fd, IPPROTO_IP, option, &value, value_length);
+            }
+        }
+
+        in_addr interface;
+        socklen_t interface_length = sizeof(interface);
+        if (getsockopt(shared_fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, &interface_length) == 0)
+        {
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, interface_length);
+        }
+    }
+    else
+    {
+        for (int option : ipv6_options)
+        {
+            value_length = sizeof(value);
+            if (getsockopt(shared_fd, IPPROTO_IPV6, option, &value, &value_length) == 0)
+            {
+                setsockopt(fd, IPPROTO_IPV6, option, &value, value_length);
+            }
+        }
+    }
+
+    value_length = sizeof(value);
+    if (getsockopt(shared_fd, SOL_SOCKET, SO_PRIORITY, &value, &value_length) == 0)
+    {
+        setsockopt(fd, SOL_SOCKET, SO_PRIORITY, &value, sizeof(value));
+    }
+
+    value_length = sizeof(value);
+    if (getsockopt(shared_fd, SOL_SOCKET, SO_SNDBUF, &value, &value_length) == 0)
+    {
+        // The kernel reports twice the size that was set.
+        value /= 2;
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+    }
+
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&local), local_length) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+#else
+    (void)shared_fd;
+    return -1;
+#endif // if defined(__linux__)
+}
+
 UDPTransportInterface::UDPTransportInterface(
     int32_t transport_kind,
     std::shared_ptr<uvw::loop> loop)
@@ -34,11 +184,40 @@ UDPTransportInterface::UDPTransportInterface(
     , loop_(loop)
     , mSendBufferSize(0)
     , mReceiveBufferSize(0)
+    , kernel_pacing_(KernelPacing::NONE)
+    , kernel_pacing_rate_(0)
+    , txtime_enabled_(false)
+    , next_txtime_(0)
+    , max_connected_sockets_(0)
+    , zerocopy_threshold_(0)
 {
 }
 
 UDPTransportInterface::~UDPTransportInterface()
 {
+    if (discovery_)
+    {
+        std::lock_guard<std::mutex> lock(discovery_->mutex);
+        discovery_->transport = nullptr;
+    }
+
+    if (read_check_)
+    {
+        read_check_->stop();
+        read_check_->close();
+    }
+
+    // The factory destroys its transports on their loops, after closing their channels.
+    for (auto &socket : udp_handles_)
+    {
+        socket->close();
+    }
+
+    // Sockets handed over by another process that no channel claimed.
+    for (auto &adopted : adopted_sockets_)
+    {
+        adopted.socket->close();
+    }
 }
 
 bool UDPTransportInterface::do_input_locators_match(
@@ -50,8 +229,413 @@ bool UDPTransportInterface::do_input_locators_match(
 
 bool UDPTransportInterface::init()
 {
+    TransportDescriptorInterface *configuration = get_configuration();
+    if (configuration)
+    {
+        mSendBufferSize = configuration->min_send_buffer_size();
+        mReceiveBufferSize = configuration->min_recv_buffer_size();
+
+        if (configuration->kernel_pacing_rate_ > 0)
+        {
+            kernel_pacing_ = configuration->kernel_pacing_;
+            kernel_pacing_rate_ = configuration->kernel_pacing_rate_;
+        }
+
+        max_connected_sockets_ = configuration->connected_sockets_;
+        zerocopy_threshold_ = configuration->zerocopy_threshold_;
+    }
+
+    txtime_enabled_ = kernel_pacing_ == KernelPacing::TXTIME;
+
+    if (!configuration || !configuration->lazy_init_)
+    {
+        discover_interfaces();
+        return true;
+    }
+
+    // Transports of different loops enumerate in parallel, on the thread pools of their loops.
+    discovery_ = std::make_shared<InterfaceDiscovery>();
+    discovery_->transport = this;
+    std::shared_ptr<InterfaceDiscovery> discovery = discovery_;
+    loop_->resource<uvw::work_req>([discovery]()
+    {
+        std::lock_guard<std::mutex> lock(discovery->mutex);
+        if (discovery->transport)
+        {
+            discovery->transport->discover_interfaces();
+        }
+    })->queue();
+    return true;
+}
+
+void UDPTransportInterface::discover_interfaces()
+{
+    std::call_once(interfaces_once_, [this]()
+    {
+        enumerate_host_ips();
+        get_ips(currentInterfaces);
+        update_multicast_interfaces();
+    });
+}
+
+void UDPTransportInterface::enumerate_host_ips()
+{
+    auto ips = std::make_shared<std::vector<IPFinder::info_IP>>();
+    IPFinder::getIPs(ips.get(), true);
+    std::atomic_store(&host_ips_, std::shared_ptr<const std::vector<IPFinder::info_IP>>(ips));
+}
+
+std::shared_ptr<const std::vector<IPFinder::info_IP>> UDPTransportInterface::host_ips()
+{
+    // The first enumeration stores the table before anything reads it, so this never recurses.
+    std::shared_ptr<const std::vector<IPFinder::info_IP>> ips = std::atomic_load(&host_ips_);
+    if (!ips)
+    {
+        discover_interfaces();
+        ips = std::atomic_load(&host_ips_);
+    }
+    return ips;
+}
+
+bool UDPTransportInterface::restricts_interfaces()
+{
+    TransportDescriptorInterface *configuration = get_configuration();
+    return configuration &&
+           (!configuration->interface_whitelist_.empty() || !configuration->interface_blacklist_.empty());
+}
+
+bool UDPTransportInterface::is_interface_allowed(
+    const IPFinder::info_IP &ip)
+{
+    TransportDescriptorInterface *configuration = get_configuration();
+    if (!configuration)
+    {
+        return true;
+    }
+
+    return IPFinder::isInterfaceAllowed(ip, configuration->interface_whitelist_,
+                   configuration->interface_blacklist_);
+}
+
+void UDPTransportInterface::filter_interfaces(
+    std::vector<IPFinder::info_IP> &ips)
+{
+    if (restricts_interfaces())
+    {
+        ips.erase(std::remove_if(ips.begin(), ips.end(), [this](const IPFinder::info_IP &ip)
+        {
+            return !is_interface_allowed(ip);
+        }), ips.end());
+    }
+}
+
+bool UDPTransportInterface::is_address_allowed(
+    const Locator &locator)
+{
+    if (!restricts_interfaces() || IPLocator::isAny(locator))
+    {
+        return true;
+    }
+
+    // get_ips already leaves the forbidden interfaces out, so the unfiltered table is needed here.
+    std::shared_ptr<const std::vector<IPFinder::info_IP>> ips = host_ips();
+    bool is_ipv6 = locator.kind == LOCATOR_KIND_UDPv6;
+    for (const IPFinder::info_IP &host_ip : *ips)
+    {
+        if ((host_ip.type == IPFinder::IP6 || host_ip.type == IPFinder::IP6_LOCAL) != is_ipv6)
+        {
+            continue;
+        }
+
+        IPFinder::info_IP ip(host_ip);
+        ip.locator.kind = locator.kind;
+        if (IPLocator::compareAddress(ip.locator, locator))
+        {
+            return is_interface_allowed(ip);
+        }
+    }
+
+    return true;
+}
+
+void UDPTransportInterface::update_multicast_interfaces()
+{
+    auto interfaces = std::make_shared<std::vector<MulticastInterface>>();
+
+    if (restricts_interfaces())
+    {
+        // Already filtered by the whitelist and blacklist.
+        std::vector<IPFinder::info_IP> ips;
+        get_ips(ips, true);
+
+        for (const IPFinder::info_IP &ip : ips)
+        {
+            // A single datagram per interface, sent from its first address.
+            uint32_t index = ip.index != 0 ? ip.index : IPFinder::getInterfaceIndex(ip.dev);
+            if (index == 0 || std::any_of(interfaces->begin(), interfaces->end(),
+                    [index](const MulticastInterface &interface)
+                    {
+                        return interface.index == index;
+                    }))
+            {
+                continue;
+            }
+
+            interfaces->push_back(MulticastInterface{index, ip.locator});
+        }
+    }
+
+    std::atomic_store(&multicast_interfaces_, std::shared_ptr<const std::vector<MulticastInterface>>(interfaces));
+}
+
+bool UDPTransportInterface::send_to_interfaces(
+    int fd,
+    const octet *send_buffer,
+    uint32_t send_buffer_size,
+    sockaddr_storage &address,
+    uint32_t address_length,
+    const std::vector<MulticastInterface> &interfaces,
+    const std::chrono::steady_clock::time_point &deadline)
+{
+#if defined(__linux__)
+    struct Datagram
+    {
+        iovec data;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(in6_pktinfo)) + CMSG_SPACE(sizeof(uint64_t))];
+    };
+
+    // The scratch buffers of each thread grow to the number of interfaces once and are reused afterwards.
+    thread_local std::vector<Datagram> datagrams;
+    thread_local std::vector<mmsghdr> headers;
+    size_t count = interfaces.size();
+    if (datagrams.size() < count)
+    {
+        datagrams.resize(count);
+        headers.resize(count);
+    }
+
+#if defined(SCM_TXTIME)
+    // Every copy leaves through its own interface, hence they all get the departure time of the message.
+    uint64_t txtime = txtime_enabled_ ? next_transmit_time(send_buffer_size) : 0;
+#endif // if defined(SCM_TXTIME)
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Datagram &datagram = datagrams[i];
+        datagram.data.iov_base = const_cast<octet *>(send_buffer);
+        datagram.data.iov_len = send_buffer_size;
+        memset(datagram.control, 0, sizeof(datagram.control));
+
+        msghdr &message = headers[i].msg_hdr;
+        memset(&headers[i], 0, sizeof(headers[i]));
+        message.msg_name = &address;
+        message.msg_namelen = address_length;
+        message.msg_iov = &datagram.data;
+        message.msg_iovlen = 1;
+        message.msg_control = datagram.control;
+
+        sockaddr_storage source;
+        IPLocator::toSockaddr(interfaces[i].address, source);
+        cmsghdr *header = reinterpret_cast<cmsghdr *>(datagram.control);
+
+        if (transport_kind_ == LOCATOR_KIND_UDPv6)
+        {
+            in6_pktinfo info = {};
+            info.ipi6_addr = reinterpret_cast<const sockaddr_in6 &>(source).sin6_addr;
+            info.ipi6_ifindex = interfaces[i].index;
+            header->cmsg_level = IPPROTO_IPV6;
+            header->cmsg_type = IPV6_PKTINFO;
+            header->cmsg_len = CMSG_LEN(sizeof(info));
+            memcpy(CMSG_DATA(header), &info, sizeof(info));
+            message.msg_controllen = CMSG_SPACE(sizeof(info));
+        }
+        else
+        {
+            in_pktinfo info = {};
+            info.ipi_spec_dst = reinterpret_cast<const sockaddr_in &>(source).sin_addr;
+            info.ipi_ifindex = static_cast<int>(interfaces[i].index);
+            header->cmsg_level = IPPROTO_IP;
+            header->cmsg_type = IP_PKTINFO;
+            header->cmsg_len = CMSG_LEN(sizeof(info));
+            memcpy(CMSG_DATA(header), &info, sizeof(info));
+            message.msg_controllen = CMSG_SPACE(sizeof(info));
+        }
+
+#if defined(SCM_TXTIME)
+        if (txtime_enabled_)
+        {
+            // CMSG_NXTHDR checks the room left against msg_controllen, which must span the whole buffer.
+            size_t pktinfo_length = message.msg_controllen;
+            message.msg_controllen = sizeof(datagram.control);
+            header = CMSG_NXTHDR(&message, header);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type = SCM_TXTIME;
+            header->cmsg_len = CMSG_LEN(sizeof(txtime));
+            memcpy(CMSG_DATA(header), &txtime, sizeof(txtime));
+            message.msg_controllen = pktinfo_length + CMSG_SPACE(sizeof(txtime));
+        }
+#endif // if defined(SCM_TXTIME)
+    }
+
+    bool success = true;
+    size_t sent = 0;
+    while (sent < count)
+    {
+        int result = ::sendmmsg(fd, headers.data() + sent, static_cast<unsigned int>(count - sent), 0);
+        if (result > 0)
+        {
+            sent += static_cast<size_t>(result);
+            continue;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if ((errno != EAGAIN && errno != EWOULDBLOCK) || remaining.count() <= 0)
+        {
+            // An interface that is down does not hold back the others.
+            success = false;
+            ++sent;
+            continue;
+        }
+
+        // Socket buffer full, wait until it drains or the blocking time expires.
+        pollfd descriptor = {fd, POLLOUT, 0};
+        if (::poll(&descriptor, 1, static_cast<int>(remaining.count())) <= 0)
+        {
+            return false;
+        }
+    }
+
+    return success;
+#else
+    (void)fd;
+    (void)send_buffer;
+    (void)send_buffer_size;
+    (void)address;
+    (void)address_length;
+    (void)interfaces;
+    (void)deadline;
+    return false;
+#endif // if defined(__linux__)
+}
+
+void UDPTransportInterface::configure_buffer_sizes(
+    std::shared_ptr<uvw::udp_handle> socket) const
+{
+    if (mSendBufferSize > 0)
+    {
+        socket->send_buffer_size(static_cast<int>(mSendBufferSize));
+    }
+
+    if (mReceiveBufferSize > 0)
+    {
+        socket->recv_buffer_size(static_cast<int>(mReceiveBufferSize));
+    }
+}
+
+void UDPTransportInterface::configure_pacing(
+    std::shared_ptr<uvw::udp_handle> socket)
+{
+#if defined(__linux__)
+    int fd = static_cast<int>(socket->fd());
+
+    if (kernel_pacing_ == KernelPacing::PACING_RATE)
+    {
+#if defined(SO_MAX_PACING_RATE)
+        // The option takes an unsigned 32 bits rate, a 64 bits one is only accepted by recent kernels.
+        uint64_t rate = kernel_pacing_rate_;
+        if (setsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &rate, sizeof(rate)) != 0)
+        {
+            uint32_t rate32 = static_cast<uint32_t>(std::min<uint64_t>(rate, UINT32_MAX));
+            setsockopt(fd, SOL_SOCKET, SO_MAX_PACING_RATE, &rate32, sizeof(rate32));
+        }
+#endif // if defined(SO_MAX_PACING_RATE)
+    }
+    else if (kernel_pacing_ == KernelPacing::TXTIME)
+    {
+#if defined(SO_TXTIME)
+        sock_txtime config = {};
+        config.clockid = CLOCK_MONOTONIC;
+        config.flags = 0;
+        if (setsockopt(fd, SOL_SOCKET, SO_TXTIME, &config, sizeof(config)) != 0)
+        {
+            txtime_enabled_ = false;
+        }
+#else
+        txtime_enabled_ = false;
+#endif // if defined(SO_TXTIME)
+    }
+#else
+    (void)socket;
+    txtime_enabled_ = false;
+#endif // if defined(__linux__)
+}
+
+uint64_t UDPTransportInterface::next_transmit_time(
+    uint32_t size)
+{
+    timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    uint64_t now = static_cast<uint64_t>(now_ts.tv_sec) * 1000000000 + static_cast<uint64_t>(now_ts.tv_nsec);
+    uint64_t duration = static_cast<uint64_t>(size) * 1000000000 / kernel_pacing_rate_;
+
+    // Datagrams queue one behind the other, an idle transport starts again from the current time.
+    uint64_t next = next_txtime_.load(std::memory_order_relaxed);
+    uint64_t departure;
+    do
+    {
+        departure = std::max(next, now);
+    } while (!next_txtime_.compare_exchange_weak(next, departure + duration, std::memory_order_relaxed));
+
+    return departure;
+}
+
+bool UDPTransportInterface::grow_receive_buffer(
+    std::shared_ptr<uvw::udp_handle> socket)
+{
+    TransportDescriptorInterface *configuration = get_configuration();
+    if (!configuration || !configuration->adaptive_recv_buffer_)
+    {
+        return false;
+    }
+
+    uint32_t current = static_cast<uint32_t>(socket->recv_buffer_size());
+#if defined(__linux__)
+    // Linux reports twice the requested size, the extra half is kept for bookkeeping.
+    current /= 2;
+#endif // if defined(__linux__)
+
+    uint32_t next = std::min(current * 2, configuration->max_recv_buffer_size_);
+    if (next <= current)
+    {
+        return false;
+    }
+
+    socket->recv_buffer_size(static_cast<int>(next));
+    return true;
+}
+
+bool UDPTransportInterface::adopt_socket(
+    const HandoffSocket &socket)
+{
+    if (!is_locator_supported(socket.locator))
+    {
+        return false;
+    }
+
+    auto handle = loop_->resource<uvw::udp_handle>();
+    if (handle->open(socket.fd) < 0)
+    {
+        handle->close();
+        return false;
+    }
 
-    get_ips(currentInterfaces);
+    adopted_sockets_.push_back({socket, handle});
     return true;
 }
 
@@ -65,36 +649,437 @@ bool UDPTransportInterface::open_output_channel(
     SendResourceList &sender_resource_list,
     const Locator &locator)
 {
-    if (!is_locator_supported(locator))
+    return open_output_channel(sender_resource_list, locator, TrafficPriority::NORMAL);
+}
+
+bool UDPTransportInterface::open_output_channel(
+    SendResourceList &sender_resource_list,
+    const Locator &locator,
+    TrafficPriority priority)
+{
+    return open_sender(sender_resource_list, locator, priority) != nullptr;
+}
+
+std::shared_ptr<UDPSenderResource> UDPTransportInterface::open_sender(
+    SendResourceList &sender_resource_list,
+    const Locator &locator,
+    TrafficPriority priority)
+{
+    if (!is_locator_supported(locator) || !is_address_allowed(locator))
     {
-        return false;
+        return nullptr;
+    }
+
+    discover_interfaces();
+
+    // The channel is already open, its sender is handed out again.
+    for (const std::shared_ptr<SenderResource> &sender : sender_resource_list)
+    {
+        auto udp_sender = std::dynamic_pointer_cast<UDPSenderResource>(sender);
+        if (udp_sender && &udp_sender->transport_ == this && udp_sender->locator() == locator &&
+                udp_sender->priority() == priority)
+        {
+            return udp_sender;
+        }
+    }
+
+    // High priority traffic never shares the socket, nor its queues, of the user data.
+    auto send_socket = take_adopted_socket(locator, priority);
+    if (!send_socket && priority == TrafficPriority::NORMAL)
+    {
+        send_socket = find_socket(locator);
+    }
+
+    if(!send_socket)
+    {
+        send_socket = loop_->resource<uvw::udp_handle>();
+
+        Locator bind_locator(locator);
+        if (priority != TrafficPriority::NORMAL)
+        {
+            bind_locator.port = 0;
+        }
+
+        sockaddr_storage address;
+        IPLocator::toSockaddr(bind_locator, address);
+        if (send_socket->bind(reinterpret_cast<const sockaddr &>(address)) < 0)
+        {
+            send_socket->close();
+            return nullptr;
+        }
+
+        configure_buffer_sizes(send_socket);
+        if (priority != TrafficPriority::NORMAL)
+        {
+            configure_priority(send_socket);
+        }
+        udp_handles_.push_back(send_socket);
+    }
+
+    configure_pacing(send_socket);
+    socket_state(send_socket);
+
+    auto sender = std::make_shared<UDPSenderResource>(locator, *this, send_socket, false, true, priority);
+
+    // Large messages leave through a sibling socket, kernel pacing is only configured on the channel socket.
+    if (zerocopy_threshold_ > 0 && kernel_pacing_ == KernelPacing::NONE)
+    {
+        int zerocopy_fd = open_sibling_socket(static_cast<int>(send_socket->fd()));
+        if (zerocopy_fd >= 0)
+        {
+            sender->zerocopy_ = ZeroCopySocket::open(loop_, zerocopy_fd);
+        }
+    }
+
+    sender_resource_list.push_back(sender);
+
+    return sender;
+}
+
+std::shared_ptr<UDPTransportInterface::SocketState> UDPTransportInterface::socket_state(
+    const std::shared_ptr<uvw::udp_handle> &socket)
+{
+    auto state = socket->data<SocketState>();
+    if (!state)
+    {
+        state = std::make_shared<SocketState>();
+        socket->data(state);
+    }
+    return state;
+}
+
+std::shared_ptr<UDPTransportInterface::ConnectedSocket> UDPTransportInterface::connected_socket(
+    const std::shared_ptr<SocketState> &state,
+    int fd,
+    const Locator &remote_locator,
+    const sockaddr_storage &address,
+    uint32_t address_length)
+{
+    if (state->read.load(std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    auto connected = std::atomic_load(&state->connected);
+    auto hot = connected->find(remote_locator);
+    if (hot != connected->end())
+    {
+        hot->second->used.store(true, std::memory_order_relaxed);
+        return hot->second;
+    }
+
+    std::lock_guard<std::mutex> lock(connected_mutex_);
+
+    // Marked read, or connected by another thread, meanwhile.
+    if (state->read.load(std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    connected = std::atomic_load(&state->connected);
+    hot = connected->find(remote_locator);
+    if (hot != connected->end())
+    {
+        return hot->second;
+    }
+
+    if (++state->cold_sends[remote_locator] < s_hotDestinationSends)
+    {
+        // Forget the counts once they span many more destinations than the cache holds.
+        if (state->cold_sends.size() > 4 * static_cast<size_t>(max_connected_sockets_))
+        {
+            state->cold_sends.clear();
+        }
+        return nullptr;
+    }
+    state->cold_sends.erase(remote_locator);
+
+    int connected_fd = open_sibling_socket(fd);
+    if (connected_fd < 0)
+    {
+        return nullptr;
     }
 
-    auto it = std::find_if(udp_handles_.begin(),udp_handles_.end(),[&locator](const std::shared_ptr<uvw::udp_handle> &handle)
+    if (::connect(connected_fd, reinterpret_cast<const sockaddr *>(&address), address_length) != 0)
     {
-        auto addr = handle->sock();
-        return IPLocator::toIPv4string(locator) == addr.ip && 
-            locator.port == addr.port;
+        ::close(connected_fd);
+        return nullptr;
+    }
+
+    // Second chance eviction: sockets used since the last pass go to the back of the clock.
+    while (!connected_clock_.empty() && connected_clock_.size() >= max_connected_sockets_)
+    {
+        auto &oldest = connected_clock_.front();
+        auto oldest_sockets = std::atomic_load(&oldest.first->connected);
+        auto candidate = oldest_sockets->find(oldest.second);
+        if (candidate != oldest_sockets->end() && candidate->second->used.exchange(false, std::memory_order_relaxed))
+        {
+            connected_clock_.splice(connected_clock_.end(), connected_clock_, connected_clock_.begin());
+            continue;
+        }
+
+        auto remaining = std::make_shared<SocketState::ConnectedSockets>(*oldest_sockets);
+        remaining->erase(oldest.second);
+        std::atomic_store(&oldest.first->connected, std::shared_ptr<const SocketState::ConnectedSockets>(remaining));
+        connected_clock_.pop_front();
+    }
+
+    // The eviction may have replaced the sockets of this state too.
+    auto socket = std::make_shared<ConnectedSocket>(connected_fd);
+    auto sockets = std::make_shared<SocketState::ConnectedSockets>(*std::atomic_load(&state->connected));
+    (*sockets)[remote_locator] = socket;
+    std::atomic_store(&state->connected, std::shared_ptr<const SocketState::ConnectedSockets>(sockets));
+
+    connected_clock_.emplace_back(state, remote_locator);
+    return socket;
+}
+
+void UDPTransportInterface::mark_socket_read(
+    const std::shared_ptr<uvw::udp_handle> &socket)
+{
+    std::shared_ptr<SocketState> state = socket_state(socket);
+    if (state->read.exchange(true))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(connected_mutex_);
+    std::atomic_store(&state->connected, std::make_shared<const SocketState::ConnectedSockets>());
+    state->cold_sends.clear();
+    connected_clock_.remove_if([&state](const std::pair<std::shared_ptr<SocketState>, Locator> &entry)
+    {
+        return entry.first == state;
     });
-    auto send_socket = it != udp_handles_.end() ? *it : loop_->resource<uvw::udp_handle>();
+}
 
-    if(send_socket)
+void UDPTransportInterface::evict_connected_socket(
+    const std::shared_ptr<SocketState> &state,
+    const Locator &remote_locator)
+{
+    std::lock_guard<std::mutex> lock(connected_mutex_);
+
+    auto sockets = std::make_shared<SocketState::ConnectedSockets>(*std::atomic_load(&state->connected));
+    if (sockets->erase(remote_locator) == 0)
+    {
+        return;
+    }
+    std::atomic_store(&state->connected, std::shared_ptr<const SocketState::ConnectedSockets>(sockets));
+    connected_clock_.remove_if([&state, &remote_locator](const std::pair<std::shared_ptr<SocketState>, Locator> &entry)
     {
-        send_socket->bind(IPLocator::toIPv4string(locator), locator.port);
+        return entry.first == state && entry.second == remote_locator;
+    });
+}
 
-        auto addr = send_socket->sock();
+bool UDPTransportInterface::join_multicast_group(
+    std::shared_ptr<uvw::udp_handle> socket,
+    const Locator &group)
+{
+    TransportDescriptorInterface *configuration = get_configuration();
 
-        if(it != udp_handles_.end())
+    // Index 0 lets the kernel choose the interface.
+    std::vector<uint32_t> interfaces;
+    auto allowed = std::atomic_load(&multicast_interfaces_);
+    if (allowed)
+    {
+        for (const MulticastInterface &interface : *allowed)
         {
-            udp_handles_.push_back(send_socket);
+            interfaces.push_back(interface.index);
         }
+    }
+    if (interfaces.empty())
+    {
+        if (restricts_interfaces())
+        {
+            return false;
+        }
+        interfaces.push_back(0);
+    }
 
-        sender_resource_list.emplace_back(
-            static_cast<SenderResource *>(new UDPSenderResource(locator, *this, send_socket, false, true))
-        );
+    int family = transport_kind_ == LOCATOR_KIND_UDPv6 ? AF_INET6 : AF_INET;
+    std::vector<sockaddr_storage> sources;
+    if (configuration)
+    {
+        for (const std::string &source : configuration->multicast_sources_)
+        {
+            sockaddr_storage address = {};
+            address.ss_family = static_cast<sa_family_t>(family);
+            void *ip = family == AF_INET6 ?
+                    static_cast<void *>(&reinterpret_cast<sockaddr_in6 &>(address).sin6_addr) :
+                    static_cast<void *>(&reinterpret_cast<sockaddr_in &>(address).sin_addr);
+            if (inet_pton(family, source.c_str(), ip) == 1)
+            {
+                sources.push_back(address);
+            }
+        }
     }
 
-    return false;
+    sockaddr_storage group_address;
+    IPLocator::toSockaddr(group, group_address);
+
+    int fd = static_cast<int>(socket->fd());
+    int level = family == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP;
+    bool joined = false;
+
+    // Sockets adopted from another process are already members, the kernel reports EADDRINUSE.
+    for (uint32_t interface : interfaces)
+    {
+        if (sources.empty())
+        {
+            group_req request = {};
+            request.gr_interface = interface;
+            memcpy(&request.gr_group, &group_address, sizeof(group_address));
+            joined |= setsockopt(fd, level, MCAST_JOIN_GROUP, &request, sizeof(request)) == 0 || errno == EADDRINUSE;
+            continue;
+        }
+
+        // The kernel drops the datagrams of any other source before they reach the socket.
+        for (const sockaddr_storage &source : sources)
+        {
+            group_source_req request = {};
+            request.gsr_interface = interface;
+            memcpy(&request.gsr_group, &group_address, sizeof(group_address));
+            memcpy(&request.gsr_source, &source, sizeof(source));
+            joined |= setsockopt(fd, level, MCAST_JOIN_SOURCE_GROUP, &request, sizeof(request)) == 0 ||
+                      errno == EADDRINUSE;
+        }
+    }
+
+    return joined;
+}
+
+void UDPTransportInterface::configure_priority(
+    std::shared_ptr<uvw::udp_handle> socket) const
+{
+    TransportDescriptorInterface *configuration = const_cast<UDPTransportInterface *>(this)->get_configuration();
+    uint8_t dscp = configuration ? configuration->high_priority_dscp_ : s_defaultHighPriorityDSCP;
+    int32_t socket_priority = configuration ?
+            configuration->high_priority_socket_priority_ : s_defaultHighPrioritySocketPriority;
+
+    int fd = static_cast<int>(socket->fd());
+    // The DSCP field is the upper six bits of the TOS / traffic class byte.
+    int tos = static_cast<int>(dscp) << 2;
+    if (transport_kind_ == LOCATOR_KIND_UDPv6)
+    {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos));
+    }
+    else
+    {
+        setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+    }
+
+#if defined(__linux__)
+    setsockopt(fd, SOL_SOCKET, SO_PRIORITY, &socket_priority, sizeof(socket_priority));
+#else
+    (void)socket_priority;
+#endif // if defined(__linux__)
+}
+
+void UDPTransportInterface::schedule_read(
+    UDPReceiverResource *receiver)
+{
+    if (!read_check_)
+    {
+        read_check_ = loop_->resource<uvw::check_handle>();
+        read_check_->on<uvw::check_event>([this](const uvw::check_event &, uvw::check_handle &handle)
+        {
+            // Receivers scheduled while reading are served in the next iteration.
+            std::vector<UDPReceiverResource *> pending;
+            pending.swap(pending_reads_);
+            for (UDPReceiverResource *receiver : pending)
+            {
+                receiver->read_pending_ = false;
+                receiver->on_readable();
+            }
+
+            if (pending_reads_.empty())
+            {
+                handle.stop();
+            }
+        });
+    }
+
+    if (!receiver->read_pending_)
+    {
+        receiver->read_pending_ = true;
+        pending_reads_.push_back(receiver);
+        read_check_->start();
+    }
+}
+
+void UDPTransportInterface::cancel_read(
+    UDPReceiverResource *receiver)
+{
+    pending_reads_.erase(std::remove(pending_reads_.begin(), pending_reads_.end(), receiver), pending_reads_.end());
+}
+
+Locator UDPTransportInterface::socket_locator(
+    const std::shared_ptr<uvw::udp_handle> &socket) const
+{
+    Locator locator;
+    sockaddr_storage address;
+    socklen_t address_length = sizeof(address);
+
+    if (getsockname(static_cast<int>(socket->fd()), reinterpret_cast<sockaddr *>(&address), &address_length) != 0 ||
+            !IPLocator::createLocator(transport_kind_, reinterpret_cast<const sockaddr *>(&address), locator))
+    {
+        LOCATOR_INVALID(locator);
+    }
+
+    return locator;
+}
+
+std::shared_ptr<uvw::udp_handle> UDPTransportInterface::find_socket(
+    const Locator &locator) const
+{
+    auto it = std::find_if(udp_handles_.begin(), udp_handles_.end(), [this, &locator](
+                const std::shared_ptr<uvw::udp_handle> &handle)
+    {
+        return socket_locator(handle) == locator;
+    });
+
+    return it != udp_handles_.end() ? *it : nullptr;
+}
+
+std::shared_ptr<uvw::udp_handle> UDPTransportInterface::take_adopted_socket(
+    const Locator &locator,
+    TrafficPriority priority)
+{
+    auto it = std::find_if(adopted_sockets_.begin(), adopted_sockets_.end(), [&locator, priority](
+                const AdoptedSocket &adopted)
+    {
+        if (!(adopted.channel.locator == locator))
+        {
+            return false;
+        }
+
+        // High priority senders never share the socket of the channel.
+        if (priority != TrafficPriority::NORMAL)
+        {
+            return !adopted.channel.input && adopted.channel.priority == priority;
+        }
+        return adopted.channel.input || adopted.channel.priority == TrafficPriority::NORMAL;
+    });
+
+    if (it == adopted_sockets_.end())
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<uvw::udp_handle> socket = it->socket;
+    adopted_sockets_.erase(it);
+    udp_handles_.push_back(socket);
+    return socket;
+}
+
+bool UDPTransportInterface::is_input_channel_open(
+    const ReceiverResourceList &receiver_resource_list,
+    const Locator &locator)
+{
+    return std::any_of(receiver_resource_list.begin(), receiver_resource_list.end(), [&locator](
+                const std::shared_ptr<ReceiverResource> &receiver)
+    {
+        return receiver->locator() == locator;
+    });
 }
 
 Locator UDPTransportInterface::remote_to_main_local(
@@ -146,21 +1131,189 @@ bool UDPTransportInterface::send(
     const octet *send_buffer,
     uint32_t send_buffer_size,
     std::shared_ptr<uvw::udp_handle> socket,
-    const Locator &remote_locator,
+    const LocatorList &locators,
     bool only_multicast_purpose,
     bool whitelisted,
-    const std::chrono::microseconds &timeout)
+    const std::chrono::steady_clock::time_point &max_blocking_time_point,
+    ZeroCopySocket &zerocopy,
+    const BufferReleaseCallback &release)
 {
-    (void)timeout;
+    bool ret = true;
+    uint32_t datagrams = 0;
+    auto time_out = std::chrono::duration_cast<std::chrono::microseconds>(
+        max_blocking_time_point - std::chrono::steady_clock::now());
+
+    {
+        auto lock = zerocopy.lock();
+        for (auto &locator : locators)
+        {
+            if (is_locator_supported(locator))
+            {
+                ret &= send(send_buffer,
+                            send_buffer_size,
+                            socket,
+                            locator,
+                            only_multicast_purpose,
+                            whitelisted,
+                            time_out,
+                            &zerocopy,
+                            &datagrams);
+            }
+        }
 
+        if (datagrams > 0)
+        {
+            zerocopy.track(send_buffer, datagrams, release);
+        }
+    }
+
+    // Every datagram was copied, or none could be sent.
+    if (datagrams == 0)
+    {
+        release(send_buffer);
+    }
+
+    return ret;
+}
+
+bool UDPTransportInterface::send(
+    const octet *send_buffer,
+    uint32_t send_buffer_size,
+    std::shared_ptr<uvw::udp_handle> socket,
+    const Locator &remote_locator,
+    bool only_multicast_purpose,
+    bool whitelisted,
+    const std::chrono::microseconds &timeout,
+    ZeroCopySocket *zerocopy,
+    uint32_t *zerocopy_datagrams)
+{
     bool success = true;
     bool is_multicast_remote_address = IPLocator::isMulticast(remote_locator);
     if (is_multicast_remote_address == only_multicast_purpose || whitelisted)
     {
-        socket->send(IPLocator::getIpByLocatorv4(remote_locator),
-                       remote_locator.port,
-                       const_cast<char*>(reinterpret_cast<const char*>(send_buffer)),
-                       send_buffer_size);
+        // The zero-copy socket has an ephemeral port and a single interface. Multicast goes out through every
+        // allowed interface, and replies must reach the receiver of the shared socket, so both are copied.
+        // Channels record the state of their socket when they open, a missing one has no receiver.
+        std::shared_ptr<SocketState> state = socket->data<SocketState>();
+        bool socket_read = state && state->read.load(std::memory_order_relaxed);
+        if (zerocopy && (is_multicast_remote_address || socket_read))
+        {
+            zerocopy = nullptr;
+        }
+
+        sockaddr_storage address;
+        uint32_t address_length = IPLocator::toSockaddr(remote_locator, address);
+        if (address_length == 0)
+        {
+            return false;
+        }
+
+#if defined(_WIN32)
+        (void)timeout;
+        success = socket->try_send(reinterpret_cast<const sockaddr &>(address),
+                        const_cast<char*>(reinterpret_cast<const char*>(send_buffer)),
+                        send_buffer_size) >= 0;
+#else
+        // The datagram is written synchronously on the socket descriptor, which keeps the caller's buffer
+        // out of the loop and makes send safe to call from any thread.
+        int shared_fd = static_cast<int>(socket->fd());
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        // Hot unicast destinations go through a connected socket, which skips the route lookup of every
+        // datagram. Kernel pacing is configured on the shared sockets only.
+        std::shared_ptr<ConnectedSocket> connected;
+        if (state && max_connected_sockets_ > 0 && !zerocopy && !is_multicast_remote_address &&
+                kernel_pacing_ == KernelPacing::NONE)
+        {
+            connected = connected_socket(state, shared_fd, remote_locator, address, address_length);
+        }
+        int fd = zerocopy ? zerocopy->fd() : connected ? connected->fd : shared_fd;
+
+#if defined(__linux__)
+        // Multicast datagrams go out through every whitelisted interface, not only the default one.
+        if (is_multicast_remote_address)
+        {
+            auto interfaces = std::atomic_load(&multicast_interfaces_);
+            if (interfaces && !interfaces->empty())
+            {
+                return send_to_interfaces(shared_fd, send_buffer, send_buffer_size, address, address_length,
+                               *interfaces, deadline);
+            }
+        }
+#endif // if defined(__linux__)
+        int flags = 0;
+#if defined(MSG_ZEROCOPY)
+        flags = zerocopy ? MSG_ZEROCOPY : 0;
+#endif // if defined(MSG_ZEROCOPY)
+
+        iovec data = {const_cast<octet *>(send_buffer), send_buffer_size};
+        msghdr message = {};
+        message.msg_name = connected ? nullptr : &address;
+        message.msg_namelen = connected ? 0 : address_length;
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+
+#if defined(__linux__) && defined(SCM_TXTIME)
+        // The departure time travels with the datagram, the qdisc holds it back until then.
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint64_t))];
+        if (txtime_enabled_)
+        {
+            uint64_t txtime = next_transmit_time(send_buffer_size);
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            cmsghdr *header = CMSG_FIRSTHDR(&message);
+            header->cmsg_level = SOL_SOCKET;
+            header->cmsg_type = SCM_TXTIME;
+            header->cmsg_len = CMSG_LEN(sizeof(txtime));
+            memcpy(CMSG_DATA(header), &txtime, sizeof(txtime));
+        }
+#endif // if defined(__linux__) && defined(SCM_TXTIME)
+
+        for (;;)
+        {
+            if (::sendmsg(fd, &message, flags) >= 0)
+            {
+                if (flags != 0)
+                {
+                    ++*zerocopy_datagrams;
+                }
+                break;
+            }
+
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // Out of pinned memory for zero-copy sends, this datagram is copied.
+            if (errno == ENOBUFS && flags != 0)
+            {
+                flags = 0;
+                continue;
+            }
+
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if ((errno != EAGAIN && errno != EWOULDBLOCK) || remaining.count() <= 0)
+            {
+                // ICMP errors are reported on connected sockets, the destination starts over as a cold one.
+                if (connected && errno == ECONNREFUSED)
+                {
+                    evict_connected_socket(state, remote_locator);
+                }
+                success = false;
+                break;
+            }
+
+            // Socket buffer full, wait until it drains or the blocking time expires.
+            pollfd descriptor = {fd, POLLOUT, 0};
+            if (::poll(&descriptor, 1, static_cast<int>(remaining.count())) <= 0)
+            {
+                success = false;
+                break;
+            }
+        }
+#endif // if defined(_WIN32)
     }
 
     return success;
@@ -203,6 +1356,9 @@ bool UDPTransportInterface::fill_unicast_locator(
 void UDPTransportInterface::update_network_interfaces()
 {
     rescan_interfaces_.store(true);
+    discover_interfaces();
+    enumerate_host_ips();
+    update_multicast_interfaces();
 }
 
 } // namespace transport
@@ -18,14 +18,22 @@
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
 #include <uvw.hpp>
 #include "IPFinder.h"
 #include "UDPReceiverResource.h"
 #include <transport/TransportInterface.h>
+#include <transport/TransportDescriptorInterface.h>
 
 namespace transport
 {
 
+class ZeroCopySocket;
+class UDPSenderResource;
+
 class UDPTransportInterface : public TransportInterface
 {
     friend class UDPSenderResource;
@@ -59,6 +67,25 @@ public:
         SendResourceList &sender_resource_list,
         const Locator &) override;
 
+    /**
+     * Opens an output channel of the given priority class. High priority channels get a socket of
+     * their own, bound to an ephemeral port and marked with the configured DSCP and SO_PRIORITY.
+     */
+    bool open_output_channel(
+        SendResourceList &sender_resource_list,
+        const Locator &locator,
+        TrafficPriority priority) override;
+
+    /**
+     * Opens an output channel like open_output_channel, and returns its sender: the one created, or the one
+     * of this transport already open on the channel.
+     * @return nullptr on failure.
+     */
+    std::shared_ptr<UDPSenderResource> open_sender(
+        SendResourceList &sender_resource_list,
+        const Locator &locator,
+        TrafficPriority priority);
+
     /**
      * Converts a given remote locator (that is, a locator referring to a remote
      * destination) to the main local locator whose channel can write to that
@@ -68,8 +95,16 @@ public:
         const Locator &) const override;
 
     /**
-     * Blocking Send through the specified channel. In both modes, using a localLocator of 0.0.0.0 will
-     * send through all whitelisted interfaces provided the channel is open.
+     * Keeps a socket handed over by another process until a channel is opened on its locator.
+     * The socket options and multicast memberships come along with the socket.
+     */
+    bool adopt_socket(
+        const HandoffSocket &socket) override;
+
+    /**
+     * Blocking Send through the specified channel. Multicast destinations are reached through every
+     * allowed interface (see TransportDescriptorInterface::interface_whitelist_), or the default one when
+     * the interfaces are not restricted.
      * @param send_buffer Slice into the raw data to send.
      * @param send_buffer_size Size of the raw data. It will be used as a bounds check for the previous argument.
      * It must not exceed the send_buffer_size fed to this class during construction.
@@ -91,6 +126,23 @@ public:
         bool whitelisted,
         const std::chrono::steady_clock::time_point &max_blocking_time_point);
 
+    /**
+     * Zero-copy send through the sibling socket of a channel. The buffer is handed to release once the
+     * kernel is done with every datagram, right away when all of them had to be copied.
+     * @param zerocopy Sibling socket of the channel.
+     * @param release Callback releasing the buffer.
+     */
+    bool send(
+        const octet *send_buffer,
+        uint32_t send_buffer_size,
+        std::shared_ptr<uvw::udp_handle> socket,
+        const LocatorList &locators,
+        bool only_multicast_purpose,
+        bool whitelisted,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        ZeroCopySocket &zerocopy,
+        const BufferReleaseCallback &release);
+
     /**
      * Performs the locator selection algorithm for this transport.
      *
@@ -127,6 +179,10 @@ protected:
     std::shared_ptr<uvw::loop> loop_;
     std::vector<std::shared_ptr<uvw::udp_handle>> udp_handles_;
 
+    //! Normal priority receivers with datagrams waiting, read once the high priority ones are drained.
+    std::vector<UDPReceiverResource *> pending_reads_;
+    std::shared_ptr<uvw::check_handle> read_check_;
+
     int32_t transport_kind_;
 
     // For UDPv6, the notion of channel corresponds to a port + direction tuple.
@@ -135,6 +191,53 @@ protected:
     uint32_t mSendBufferSize;
     uint32_t mReceiveBufferSize;
 
+    KernelPacing kernel_pacing_;
+    uint64_t kernel_pacing_rate_;
+    //! Whether the send sockets accept SCM_TXTIME stamps.
+    std::atomic_bool txtime_enabled_;
+    //! CLOCK_MONOTONIC time, in nanoseconds, at which the next datagram may leave.
+    std::atomic<uint64_t> next_txtime_;
+
+    //! Socket connect()ed to a single destination, closed with its last user.
+    struct ConnectedSocket;
+    //! State of a shared socket the senders read on every send, kept as the user data of its handle.
+    struct SocketState;
+
+    //! Interface multicast datagrams are sent through, and the address they are sent from.
+    struct MulticastInterface
+    {
+        uint32_t index;
+        Locator address;
+    };
+
+    //! Background enumeration of the interfaces, shared with the thread pool of the loop.
+    struct InterfaceDiscovery;
+    std::shared_ptr<InterfaceDiscovery> discovery_;
+    //! Guards the first enumeration of the interfaces, done by whoever needs it first.
+    std::once_flag interfaces_once_;
+
+    //! Allowed interfaces, replaced as a whole when the interfaces of the host change.
+    std::shared_ptr<const std::vector<MulticastInterface>> multicast_interfaces_;
+
+    //! Addresses of every interface of the host, loopback included and not filtered, as last enumerated.
+    std::shared_ptr<const std::vector<IPFinder::info_IP>> host_ips_;
+
+    uint32_t max_connected_sockets_;
+    //! Size from which messages sent with a release callback go zero-copy, 0 when disabled.
+    uint32_t zerocopy_threshold_;
+    //! Guards the creation and eviction of connected sockets, sends to hot destinations do not take it.
+    std::mutex connected_mutex_;
+    //! Connected sockets of every shared socket, in eviction order. Used ones get a second chance.
+    std::list<std::pair<std::shared_ptr<SocketState>, Locator>> connected_clock_;
+
+    //! Socket handed over by another process, waiting for its channel.
+    struct AdoptedSocket
+    {
+        HandoffSocket channel;
+        std::shared_ptr<uvw::udp_handle> socket;
+    };
+    std::vector<AdoptedSocket> adopted_sockets_;
+
     UDPTransportInterface(
         int32_t transport_kind,
         std::shared_ptr<uvw::loop> loop);
@@ -146,10 +249,173 @@ protected:
         const Locator &lh,
         const Locator &rh) const = 0;
 
+    //! Allowed addresses of the family of the transport, taken from host_ips().
     virtual void get_ips(
         std::vector<IPFinder::info_IP> &locNames,
         bool return_loopback = false) = 0;
 
+    //! Returns the locator a socket is bound to, built from its binary socket address.
+    Locator socket_locator(
+        const std::shared_ptr<uvw::udp_handle> &socket) const;
+
+    //! Returns the socket already bound to the given locator, nullptr if there is none.
+    std::shared_ptr<uvw::udp_handle> find_socket(
+        const Locator &locator) const;
+
+    /**
+     * Returns the adopted socket of a channel, nullptr if there is none. The socket of a receiver or of a
+     * normal sender serves the receivers and normal senders of its locator, the one of a high priority
+     * sender only the high priority senders.
+     * The socket is moved to udp_handles_, so that later channels find it as any other bound socket.
+     */
+    std::shared_ptr<uvw::udp_handle> take_adopted_socket(
+        const Locator &locator,
+        TrafficPriority priority = TrafficPriority::NORMAL);
+
+    //! Reports whether a receiver for the given locator is already in the list.
+    static bool is_input_channel_open(
+        const ReceiverResourceList &receiver_resource_list,
+        const Locator &locator);
+
+    //! Applies the configured send and receive buffer sizes to a bound socket.
+    void configure_buffer_sizes(
+        std::shared_ptr<uvw::udp_handle> socket) const;
+
+    /**
+     * Returns the state of a shared socket, created on first use. Called from the thread of the loop, when
+     * a channel opens, so that the senders only ever read it.
+     */
+    std::shared_ptr<SocketState> socket_state(
+        const std::shared_ptr<uvw::udp_handle> &socket);
+
+    /**
+     * Returns the connected socket standing for a shared socket towards a destination, nullptr while the
+     * destination is cold. Destinations get a connected socket once they have been sent to a few times,
+     * evicting one not used lately when the cache is full. Hot destinations are found without locking.
+     * Connected sockets send from an ephemeral port, so shared sockets read by a receiver never get one:
+     * the replies of the destination must keep reaching the receiver.
+     * @param state State of the shared socket.
+     * @param fd Descriptor of the shared socket.
+     * @param remote_locator Destination.
+     * @param address Socket address of the destination.
+     * @param address_length Length of address.
+     */
+    std::shared_ptr<ConnectedSocket> connected_socket(
+        const std::shared_ptr<SocketState> &state,
+        int fd,
+        const Locator &remote_locator,
+        const sockaddr_storage &address,
+        uint32_t address_length);
+
+    //! Drops the connected socket of a destination, after the kernel reported it unreachable.
+    void evict_connected_socket(
+        const std::shared_ptr<SocketState> &state,
+        const Locator &remote_locator);
+
+    //! Records that a receiver reads a shared socket, and drops the connected sockets standing for it.
+    void mark_socket_read(
+        const std::shared_ptr<uvw::udp_handle> &socket);
+
+    /**
+     * Joins a multicast group on every allowed interface, or on the default one when the interfaces are not
+     * restricted, for the configured sources only when there are some.
+     * @return true if the group was joined on at least one interface.
+     */
+    bool join_multicast_group(
+        std::shared_ptr<uvw::udp_handle> socket,
+        const Locator &group);
+
+    //! Reports whether the descriptor restricts the interfaces of the transport.
+    bool restricts_interfaces();
+
+    //! Applies the interface whitelist and blacklist of the descriptor.
+    bool is_interface_allowed(
+        const IPFinder::info_IP &ip);
+
+    //! Removes the addresses of the interfaces the transport may not use.
+    void filter_interfaces(
+        std::vector<IPFinder::info_IP> &ips);
+
+    /**
+     * Reports whether a socket may be bound to the address of a locator. The wildcard address and
+     * addresses not belonging to this host (the bind fails on its own) are allowed.
+     * Looks the address up in the enumerated interfaces, waiting for the first enumeration if needed.
+     */
+    bool is_address_allowed(
+        const Locator &locator);
+
+    //! Resolves the allowed interfaces multicast groups are joined and datagrams sent on.
+    void update_multicast_interfaces();
+
+    /**
+     * Enumerates the interfaces of the host the first time it is called, later calls return at once.
+     * Called by the channels being opened, and by the background enumeration of lazily initialized transports.
+     */
+    void discover_interfaces();
+
+    //! Enumerates the interfaces of the host into host_ips_.
+    void enumerate_host_ips();
+
+    /**
+     * Returns the interfaces of the host as last enumerated, waiting for the first enumeration if needed.
+     * They are only enumerated again by update_network_interfaces.
+     */
+    std::shared_ptr<const std::vector<IPFinder::info_IP>> host_ips();
+
+    /**
+     * Sends a copy of a multicast datagram through every interface, with a single sendmmsg call.
+     * Each copy carries the interface index and source address in an IP_PKTINFO / IPV6_PKTINFO message,
+     * so a single socket serves every interface. With kernel pacing through SO_TXTIME, every copy also
+     * carries the departure time of the message.
+     * @return false if the datagram could not be sent through some interface.
+     */
+    bool send_to_interfaces(
+        int fd,
+        const octet *send_buffer,
+        uint32_t send_buffer_size,
+        sockaddr_storage &address,
+        uint32_t address_length,
+        const std::vector<MulticastInterface> &interfaces,
+        const std::chrono::steady_clock::time_point &deadline);
+
+    //! Marks a socket with the DSCP and SO_PRIORITY of high priority traffic.
+    void configure_priority(
+        std::shared_ptr<uvw::udp_handle> socket) const;
+
+    /**
+     * Defers the read of a normal priority receiver to the check phase of the loop, which runs after
+     * every readable socket of the iteration has been reported, so high priority receivers, read as soon
+     * as they are reported, always go first.
+     */
+    void schedule_read(
+        UDPReceiverResource *receiver);
+
+    //! Forgets a receiver being destroyed.
+    void cancel_read(
+        UDPReceiverResource *receiver);
+
+    /**
+     * Hands the pacing of a send socket to the kernel, as configured by kernel_pacing_.
+     * Sockets not supporting SO_TXTIME disable the stamping of the whole transport.
+     */
+    void configure_pacing(
+        std::shared_ptr<uvw::udp_handle> socket);
+
+    /**
+     * Reserves the transmission of size bytes at kernel_pacing_rate_.
+     * @return CLOCK_MONOTONIC time, in nanoseconds, at which the datagram should leave.
+     */
+    uint64_t next_transmit_time(
+        uint32_t size);
+
+    /**
+     * Doubles the receive buffer of a socket, without exceeding the configured maximum.
+     * Called by the receivers when the kernel reports dropped datagrams.
+     * @return true if the buffer was grown.
+     */
+    bool grow_receive_buffer(
+        std::shared_ptr<uvw::udp_handle> socket);
+
     /**
      * Send a buffer to a destination
      */
@@ -160,7 +426,9 @@ protected:
         const Locator &remote_locator,
         bool only_multicast_purpose,
         bool whitelisted,
-        const std::chrono::microseconds &timeout);
+        const std::chrono::microseconds &timeout,
+        ZeroCopySocket *zerocopy = nullptr,
+        uint32_t *zerocopy_datagrams = nullptr);
 };
 
 } // namespace transport
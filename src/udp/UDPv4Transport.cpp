@@ -26,19 +26,19 @@ namespace transport
 {
 
 static void get_ipv4s(
+    const std::vector<IPFinder::info_IP> &host_ips,
     std::vector<IPFinder::info_IP> &locNames,
     bool return_loopback = false)
 {
-    IPFinder::getIPs(&locNames, return_loopback);
-    auto new_end = remove_if(locNames.begin(),
-                                locNames.end(),
-                                [](IPFinder::info_IP ip)
-                                {
-                                    return ip.type != IPFinder::IP4 && ip.type != IPFinder::IP4_LOCAL;
-                                });
-    locNames.erase(new_end, locNames.end());
-    std::for_each(locNames.begin(), locNames.end(), [](IPFinder::info_IP &loc)
-                    { loc.locator.kind = LOCATOR_KIND_UDPv4; });
+    locNames.clear();
+    for (const IPFinder::info_IP &ip : host_ips)
+    {
+        if (ip.type == IPFinder::IP4 || (return_loopback && ip.type == IPFinder::IP4_LOCAL))
+        {
+            locNames.push_back(ip);
+            locNames.back().locator.kind = LOCATOR_KIND_UDPv4;
+        }
+    }
 }
 
 UDPv4Transport::UDPv4Transport(
@@ -54,6 +54,11 @@ UDPv4Transport::~UDPv4Transport()
 {
 }
 
+TransportDescriptorInterface *UDPv4Transport::get_configuration()
+{
+    return descriptor_.get();
+}
+
 bool UDPv4Transport::default_metatraffic_multicast_locators(
     LocatorList &locators,
     uint32_t metatraffic_multicast_port) const
@@ -97,7 +102,8 @@ void UDPv4Transport::get_ips(
     std::vector<IPFinder::info_IP> &locNames,
     bool return_loopback)
 {
-    get_ipv4s(locNames, return_loopback);
+    get_ipv4s(*host_ips(), locNames, return_loopback);
+    filter_interfaces(locNames);
 }
 
 bool UDPv4Transport::open_input_channel(
@@ -105,26 +111,45 @@ bool UDPv4Transport::open_input_channel(
     const Locator &locator,
     uint32_t maxMsgSize)
 {
-    if (!is_locator_supported(locator))
+    if (!is_locator_supported(locator) || !is_address_allowed(locator))
     {
         return false;
     }
 
-    auto it = std::find_if(udp_handles_.begin(),udp_handles_.end(),[&locator](const std::shared_ptr<uvw::udp_handle> &handle)
+    discover_interfaces();
+
+    // The channel is already open, the factory will hand out its receiver.
+    if (is_input_channel_open(receiver_resource_list, locator))
     {
-        auto addr = handle->sock();
-        return IPLocator::toIPv4string(locator) == addr.ip && 
-            locator.port == addr.port;
-    });
-    auto socket = it != udp_handles_.end() ? *it : loop_->resource<uvw::udp_handle>();
+        return true;
+    }
+
+    auto socket = take_adopted_socket(locator);
+    bool adopted = socket != nullptr;
+    if (!socket)
+    {
+        socket = find_socket(locator);
+    }
+    bool reused = socket != nullptr;
+    if (!reused)
+    {
+        socket = loop_->resource<uvw::udp_handle>();
+    }
+
+    // Sockets found open are shared with other channels, the others are closed when the channel fails.
+    bool owned = !reused || adopted;
 
     auto recv_resource = std::make_shared<UDPReceiverResource>(this, socket, maxMsgSize, locator);
 
     if (IPLocator::isMulticast(locator))
     {
-        if (socket->bind("0.0.0.0", locator.port, uvw::details::uvw_udp_flags::REUSEADDR) < 0 ||
-                !socket->multicast_membership(IPLocator::getIpByLocatorv4(locator), "0.0.0.0",uvw::udp_handle::membership::JOIN_GROUP))
+        if ((!reused && socket->bind(s_IPv4AddressAny, locator.port, uvw::details::uvw_udp_flags::REUSEADDR) < 0) ||
+                !join_multicast_group(socket, locator))
         {
+            if (owned)
+            {
+                socket->close();
+            }
             return false;
         }
 
@@ -132,27 +157,28 @@ bool UDPv4Transport::open_input_channel(
         {
             socket->multicast_ttl(descriptor_->ttl_);
         }
-        
-        if(it != udp_handles_.end())
-        {
-            udp_handles_.push_back(socket);
-        }
-
-        receiver_resource_list.push_back(recv_resource);
     }
     else
     {
-        if (socket->bind(IPLocator::toIPv4string(locator), locator.port) < 0)
+        if (!reused && socket->bind(IPLocator::toIPv4string(locator), locator.port) < 0)
         {
+            if (owned)
+            {
+                socket->close();
+            }
             return false;
         }
-
-        receiver_resource_list.push_back(recv_resource);
     }
-    if(socket)
+
+    if (!reused)
     {
-        socket->recv();
+        configure_buffer_sizes(socket);
+        udp_handles_.push_back(socket);
     }
+
+    receiver_resource_list.push_back(recv_resource);
+    recv_resource->start();
+    mark_socket_read(socket);
     return true;
 }
 
@@ -164,7 +190,7 @@ LocatorList UDPv4Transport::normalize_locator(
     if (IPLocator::isAny(locator))
     {
         std::vector<IPFinder::info_IP> locNames;
-        get_ipv4s(locNames);
+        get_ips(locNames);
         for (const auto &infoIP : locNames)
         {
             Locator newloc(locator);
@@ -51,7 +51,7 @@ public:
 
     virtual ~UDPv4Transport() override;
 
-    // const UDPTransportDescriptor *configuration() const override;
+    TransportDescriptorInterface *get_configuration() override;
 
     /**
      * Starts listening on the specified port, and if the specified address is in the
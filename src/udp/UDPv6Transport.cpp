@@ -19,25 +19,28 @@
 #include "UDPv6Transport.h"
 #include <transport/TransportInterface.h>
 #include <transport/SenderResource.h>
+#include <transport/TransportDescriptorInterface.h>
+#include <transport/ReceiverResource.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 namespace transport
 {
 
 static void get_ipv6s(
+    const std::vector<IPFinder::info_IP> &host_ips,
     std::vector<IPFinder::info_IP> &locNames,
     bool return_loopback = false)
 {
-    IPFinder::getIPs(&locNames, return_loopback);
-    // Controller out IP4
-    auto new_end = remove_if(locNames.begin(),
-                                locNames.end(),
-                                [](IPFinder::info_IP ip)
-                                {
-                                    return ip.type != IPFinder::IP6 && ip.type != IPFinder::IP6_LOCAL;
-                                });
-    locNames.erase(new_end, locNames.end());
-    std::for_each(locNames.begin(), locNames.end(), [](IPFinder::info_IP &loc)
-                    { loc.locator.kind = LOCATOR_KIND_UDPv6; });
+    locNames.clear();
+    for (const IPFinder::info_IP &ip : host_ips)
+    {
+        if (ip.type == IPFinder::IP6 || (return_loopback && ip.type == IPFinder::IP6_LOCAL))
+        {
+            locNames.push_back(ip);
+            locNames.back().locator.kind = LOCATOR_KIND_UDPv6;
+        }
+    }
 }
 
 UDPv6Transport::UDPv6Transport(
@@ -52,6 +55,11 @@ UDPv6Transport::~UDPv6Transport()
 {
 }
 
+TransportDescriptorInterface *UDPv6Transport::get_configuration()
+{
+    return descriptor_.get();
+}
+
 bool UDPv6Transport::default_metatraffic_multicast_locators(
     LocatorList &locators,
     uint32_t metatraffic_multicast_port) const
@@ -95,7 +103,8 @@ void UDPv6Transport::get_ips(
     std::vector<IPFinder::info_IP> &locNames,
     bool return_loopback)
 {
-    get_ipv6s(locNames, return_loopback);
+    get_ipv6s(*host_ips(), locNames, return_loopback);
+    filter_interfaces(locNames);
 }
 
 bool UDPv6Transport::open_input_channel(
@@ -103,9 +112,82 @@ bool UDPv6Transport::open_input_channel(
     const Locator &locator,
     uint32_t maxMsgSize)
 {
-    (void)receiver_resource_list;
-    (void)locator;
-    (void)maxMsgSize;
+    if (!is_locator_supported(locator) || !is_address_allowed(locator))
+    {
+        return false;
+    }
+
+    discover_interfaces();
+
+    // The channel is already open, the factory will hand out its receiver.
+    if (is_input_channel_open(receiver_resource_list, locator))
+    {
+        return true;
+    }
+
+    auto socket = take_adopted_socket(locator);
+    bool adopted = socket != nullptr;
+    if (!socket)
+    {
+        socket = find_socket(locator);
+    }
+    bool reused = socket != nullptr;
+    if (!reused)
+    {
+        socket = loop_->resource<uvw::udp_handle>();
+    }
+
+    // Sockets found open are shared with other channels, the others are closed when the channel fails.
+    bool owned = !reused || adopted;
+
+    auto recv_resource = std::make_shared<UDPReceiverResource>(this, socket, maxMsgSize, locator);
+
+    sockaddr_storage address;
+    if (IPLocator::isMulticast(locator))
+    {
+        // Listen on the wildcard address and join the ff0x:: group on the configured interfaces.
+        Locator any_locator(locator);
+        any_locator.set_invalid_address();
+        IPLocator::toSockaddr(any_locator, address);
+
+        if ((!reused && socket->bind(reinterpret_cast<const sockaddr &>(address),
+                        uvw::details::uvw_udp_flags::REUSEADDR) < 0) ||
+                !join_multicast_group(socket, locator))
+        {
+            if (owned)
+            {
+                socket->close();
+            }
+            return false;
+        }
+
+        if(descriptor_ && descriptor_->ttl_)
+        {
+            socket->multicast_ttl(descriptor_->ttl_);
+        }
+    }
+    else
+    {
+        IPLocator::toSockaddr(locator, address);
+        if (!reused && socket->bind(reinterpret_cast<const sockaddr &>(address)) < 0)
+        {
+            if (owned)
+            {
+                socket->close();
+            }
+            return false;
+        }
+    }
+
+    if (!reused)
+    {
+        configure_buffer_sizes(socket);
+        udp_handles_.push_back(socket);
+    }
+
+    receiver_resource_list.push_back(recv_resource);
+    recv_resource->start();
+    mark_socket_read(socket);
     return true;
 }
 
@@ -116,7 +198,7 @@ LocatorList UDPv6Transport::normalize_locator(
     if (IPLocator::isAny(locator))
     {
         std::vector<IPFinder::info_IP> locNames;
-        get_ipv6s(locNames);
+        get_ips(locNames);
         for (const auto &infoIP : locNames)
         {
             Locator newloc(locator);
@@ -0,0 +1,209 @@
+// Copyright 2019 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ZeroCopySocket.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <uvw.hpp>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#endif // if defined(__linux__)
+
+namespace transport
+{
+
+//! Period of the timer draining the completions while messages are in flight.
+constexpr std::chrono::milliseconds s_zeroCopyDrainPeriod{1};
+
+std::shared_ptr<ZeroCopySocket> ZeroCopySocket::open(
+    std::shared_ptr<uvw::loop> loop,
+    int fd)
+{
+#if defined(__linux__) && defined(SO_ZEROCOPY)
+    int enable = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) != 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<ZeroCopySocket> socket(new ZeroCopySocket(fd));
+    ZeroCopySocket *raw = socket.get();
+
+    socket->timer_ = loop->resource<uvw::timer_handle>();
+    socket->timer_->on<uvw::timer_event>([raw](const uvw::timer_event &, uvw::timer_handle &)
+    {
+        raw->drain();
+    });
+
+    socket->wakeup_ = loop->resource<uvw::async_handle>();
+    socket->wakeup_->on<uvw::async_event>([raw](const uvw::async_event &, uvw::async_handle &)
+    {
+        if (!raw->timer_->active())
+        {
+            raw->timer_->start(s_zeroCopyDrainPeriod, s_zeroCopyDrainPeriod);
+        }
+    });
+
+    return socket;
+#else
+    (void)loop;
+    ::close(fd);
+    return nullptr;
+#endif // if defined(__linux__) && defined(SO_ZEROCOPY)
+}
+
+ZeroCopySocket::ZeroCopySocket(
+    int fd)
+    : fd_(fd)
+    , next_id_(0)
+{
+}
+
+ZeroCopySocket::~ZeroCopySocket()
+{
+    if (timer_)
+    {
+        timer_->stop();
+        timer_->close();
+    }
+    if (wakeup_)
+    {
+        wakeup_->close();
+    }
+
+    ::close(fd_);
+
+    // The kernel keeps the pages of the datagrams still queued, their buffers are handed back anyway.
+    for (Message &message : messages_)
+    {
+        message.release(message.data);
+    }
+}
+
+void ZeroCopySocket::track(
+    const octet *data,
+    uint32_t datagrams,
+    const BufferReleaseCallback &release)
+{
+    messages_.push_back(Message{next_id_, datagrams, datagrams, data, release});
+    next_id_ += datagrams;
+    wakeup_->send();
+}
+
+void ZeroCopySocket::drain()
+{
+#if defined(__linux__) && defined(SO_EE_ORIGIN_ZEROCOPY)
+    std::vector<Message> finished;
+
+    for (;;)
+    {
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_storage))];
+        msghdr msg = {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (::recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+        {
+            // EAGAIN means the error queue has been drained.
+            break;
+        }
+
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+                    !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+            {
+                continue;
+            }
+
+            sock_extended_err error;
+            memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+            if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            {
+                continue;
+            }
+
+            // The kernel reports the inclusive range [ee_info, ee_data] of counter values.
+            std::lock_guard<std::mutex> lock(mutex_);
+            complete(messages_, error.ee_info, error.ee_data, finished);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (messages_.empty())
+        {
+            timer_->stop();
+        }
+    }
+
+    for (Message &message : finished)
+    {
+        message.release(message.data);
+    }
+#endif // if defined(__linux__) && defined(SO_EE_ORIGIN_ZEROCOPY)
+}
+
+void ZeroCopySocket::complete(
+    std::deque<Message> &messages,
+    uint32_t low,
+    uint32_t high,
+    std::vector<Message> &finished)
+{
+    if (messages.empty())
+    {
+        return;
+    }
+
+    uint32_t base = messages.front().first;
+    low -= base;
+    high -= base;
+
+    // Values before the oldest message in flight are already accounted.
+    if (low > high)
+    {
+        low = 0;
+    }
+
+    for (Message &message : messages)
+    {
+        uint32_t first = message.first - base;
+        uint32_t last = first + message.count - 1;
+        if (first > high)
+        {
+            break;
+        }
+        if (last < low)
+        {
+            continue;
+        }
+
+        message.remaining -= std::min(last, high) - std::max(first, low) + 1;
+    }
+
+    auto done = std::stable_partition(messages.begin(), messages.end(), [](const Message &message)
+    {
+        return message.remaining == 0;
+    });
+    std::move(messages.begin(), done, std::back_inserter(finished));
+    messages.erase(messages.begin(), done);
+}
+
+} // namespace transport
@@ -0,0 +1,135 @@
+// Copyright 2019 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_UDP_ZERO_COPY_SOCKET_H_
+#define TRANSPORT_UDP_ZERO_COPY_SOCKET_H_
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <transport/type.h>
+#include <transport/SenderResource.h>
+
+namespace uvw
+{
+    class loop;
+    class async_handle;
+    class timer_handle;
+}
+
+namespace transport
+{
+
+/**
+ * Send only socket with SO_ZEROCOPY enabled, bound to the address of a channel with an ephemeral port.
+ * Every datagram sent with MSG_ZEROCOPY gets the next value of a counter, and the kernel reports the
+ * ranges of values it is done with on the error queue of the socket. The socket is not watched by the
+ * loop, whose poll handles stop on error queue events; a timer drains the error queue instead while
+ * messages are in flight, and invokes their release callbacks.
+ */
+class ZeroCopySocket
+{
+public:
+    //! Message in flight, whose datagrams got the counter values [first, first + count).
+    struct Message
+    {
+        uint32_t first;
+        uint32_t count;
+        //! Datagrams the kernel has not reported yet.
+        uint32_t remaining;
+        const octet *data;
+        BufferReleaseCallback release;
+    };
+    /**
+     * Enables zero-copy sends on a bound socket. Must be called from the thread of the loop.
+     * @param loop Loop of the channel, which runs the release callbacks.
+     * @param fd Descriptor of the socket, owned by the returned object. Closed on failure.
+     * @return nullptr when the kernel does not support zero-copy sends on UDP sockets.
+     */
+    static std::shared_ptr<ZeroCopySocket> open(
+        std::shared_ptr<uvw::loop> loop,
+        int fd);
+
+    //! Releases the messages still in flight.
+    ~ZeroCopySocket();
+
+    int fd() const
+    {
+        return fd_;
+    }
+
+    /**
+     * Serializes the senders of the socket, the datagrams of a message must get consecutive counter values.
+     * Held around the sends of a message and the call to track.
+     */
+    std::unique_lock<std::mutex> lock()
+    {
+        return std::unique_lock<std::mutex>(mutex_);
+    }
+
+    /**
+     * Records a message whose datagrams have just been sent with MSG_ZEROCOPY. Called with the lock held.
+     * @param data Buffer of the message.
+     * @param datagrams Number of datagrams accepted by the kernel, at least one.
+     * @param release Callback invoked once the kernel is done with every datagram.
+     */
+    void track(
+        const octet *data,
+        uint32_t datagrams,
+        const BufferReleaseCallback &release);
+
+    /**
+     * Accounts a completion reported by the kernel to the messages in flight.
+     * Values are compared relative to the oldest message, so the counter may wrap around.
+     * @param messages Messages in flight, in sending order.
+     * @param low First counter value of the inclusive range reported.
+     * @param high Last counter value of the inclusive range reported.
+     * @param[out] finished Receives the messages whose datagrams are all complete, removed from messages.
+     */
+    static void complete(
+        std::deque<Message> &messages,
+        uint32_t low,
+        uint32_t high,
+        std::vector<Message> &finished);
+
+private:
+
+    ZeroCopySocket(
+        int fd);
+
+    ZeroCopySocket(
+        const ZeroCopySocket &) = delete;
+    ZeroCopySocket &operator=(
+        const ZeroCopySocket &) = delete;
+
+    //! Reads the completions queued on the error queue and releases the finished messages.
+    void drain();
+
+    int fd_;
+
+    std::mutex mutex_;
+    //! Counter value of the next datagram.
+    uint32_t next_id_;
+    //! Messages in flight, in sending order.
+    std::deque<Message> messages_;
+
+    //! Wakes the loop from the sending threads to start the timer.
+    std::shared_ptr<uvw::async_handle> wakeup_;
+    std::shared_ptr<uvw::timer_handle> timer_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_UDP_ZERO_COPY_SOCKET_H_
@@ -0,0 +1,148 @@
+// Copyright 2019 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "UDSReceiverResource.h"
+#include "UDSTransport.h"
+#include <uvw.hpp>
+#include <cstring>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace transport
+{
+
+//! Maximum number of datagrams read in a single readable event, so one busy socket cannot starve the loop.
+constexpr uint32_t s_maxDatagramsPerEvent = 64;
+
+UDSReceiverResource::UDSReceiverResource(
+    UDSTransport *transport,
+    int fd,
+    uint32_t maxMsgSize,
+    const Locator &locator)
+    : ReceiverResource(locator, maxMsgSize)
+    , transport_(transport)
+    , fd_(fd)
+    , local_channel_(false)
+    , poll_(nullptr)
+{
+    locator_check_callback_ = [this](const Locator &locatorToCheck) -> bool
+    {
+        return locator_.kind == locatorToCheck.kind && transport_->do_input_locators_match(locator_, locatorToCheck);
+    };
+}
+
+UDSReceiverResource::~UDSReceiverResource()
+{
+    if (poll_)
+    {
+        poll_->stop();
+        poll_->close();
+    }
+
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+
+        // Socket files outlive their descriptor, abstract names do not.
+        sockaddr_un address;
+        UDSTransport::socket_address(locator_, address);
+        if (address.sun_path[0] != '\0')
+        {
+            ::unlink(address.sun_path);
+        }
+    }
+}
+
+void UDSReceiverResource::register_receiver(
+    const ReceiveCallback &callback)
+{
+    recv_callback_ = callback;
+}
+
+void UDSReceiverResource::start()
+{
+    buffer_.resize(max_message_size_);
+    local_channel_ = locator_.kind != LOCATOR_KIND_UDS;
+    poll_ = transport_->loop_->resource<uvw::poll_handle>(fd_);
+    poll_->on<uvw::poll_event>([this](const uvw::poll_event &, uvw::poll_handle &)
+    {
+        on_readable();
+    });
+    poll_->start(uvw::poll_handle::poll_event_flags::READABLE);
+}
+
+void UDSReceiverResource::on_readable()
+{
+    // Output channels are unbound, the sender of a datagram is only known by its kind.
+    Locator remote_locator;
+    remote_locator.kind = LOCATOR_KIND_UDS;
+    remote_locator.port = LOCATOR_PORT_INVALID;
+    remote_locator.set_invalid_address();
+
+    // Datagrams of local channels start with the UDP locator of their sender, read apart from the message.
+    LocalSourceHeader header;
+    iovec iov[2] = {{&header, sizeof(header)}, {buffer_.data(), buffer_.size()}};
+    msghdr message = {};
+    message.msg_iov = local_channel_ ? iov : iov + 1;
+    message.msg_iovlen = local_channel_ ? 2 : 1;
+
+    for (uint32_t i = 0; i < s_maxDatagramsPerEvent; ++i)
+    {
+        ssize_t received = ::recvmsg(fd_, &message, MSG_DONTWAIT);
+        if (received < 0)
+        {
+            // EAGAIN means the queue has been drained.
+            break;
+        }
+
+        if (local_channel_)
+        {
+            if (received < static_cast<ssize_t>(sizeof(header)) ||
+                    (header.kind != LOCATOR_KIND_UDPv4 && header.kind != LOCATOR_KIND_UDPv6))
+            {
+                continue;
+            }
+
+            received -= sizeof(header);
+            remote_locator.kind = header.kind;
+            remote_locator.port = header.port;
+            memcpy(remote_locator.address, header.address, sizeof(header.address));
+        }
+
+        deliver(buffer_.data(), static_cast<uint32_t>(received), locator_, remote_locator, ReceiveMetadata());
+    }
+}
+
+ReceiverStatistics UDSReceiverResource::statistics() const
+{
+    ReceiverStatistics stats = ReceiverResource::statistics();
+
+    int queued = 0;
+    if (ioctl(fd_, FIONREAD, &queued) == 0)
+    {
+        stats.queued_bytes = static_cast<uint32_t>(queued);
+    }
+
+    int buffer_size = 0;
+    socklen_t len = sizeof(buffer_size);
+    if (getsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &buffer_size, &len) == 0)
+    {
+        stats.buffer_size = static_cast<uint32_t>(buffer_size);
+    }
+
+    return stats;
+}
+
+} // namespace transport
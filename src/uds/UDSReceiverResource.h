@@ -0,0 +1,79 @@
+// Copyright 2019 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_UDS_RECEIVER_RESOURCE_H_
+#define TRANSPORT_UDS_RECEIVER_RESOURCE_H_
+
+#include <transport/type.h>
+#include <transport/ReceiverResource.h>
+
+#include <memory>
+#include <vector>
+
+namespace uvw
+{
+    class poll_handle;
+}
+
+namespace transport
+{
+class UDSTransport;
+
+class UDSReceiverResource : public ReceiverResource
+{
+public:
+    /**
+     * @param transport Transport owning the channel.
+     * @param fd Bound socket, owned by the resource from now on.
+     * @param maxMsgSize Maximum size of the received messages.
+     * @param locator Locator of the channel, the UDP locator of the receiver for local channels.
+     */
+    UDSReceiverResource(
+        UDSTransport *transport,
+        int fd,
+        uint32_t maxMsgSize,
+        const Locator &locator);
+
+    virtual ~UDSReceiverResource();
+
+    void register_receiver(
+        const ReceiveCallback &callback) override;
+
+    //! Starts reading from the socket.
+    void start();
+
+    ReceiverStatistics statistics() const override;
+
+private:
+    //! Drains the datagrams currently queued in the socket.
+    void on_readable();
+
+    UDSTransport *transport_;
+    int fd_;
+    //! Local channel of an UDP receiver, whose datagrams carry the locator of their sender.
+    bool local_channel_;
+    std::shared_ptr<uvw::poll_handle> poll_;
+
+    //! Reception buffer, sized to the maximum message size.
+    std::vector<octet> buffer_;
+
+    UDSReceiverResource(
+        const UDSReceiverResource &) = delete;
+    UDSReceiverResource &operator=(
+        const UDSReceiverResource &) = delete;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_UDS_RECEIVER_RESOURCE_H_
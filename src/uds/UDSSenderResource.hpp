@@ -0,0 +1,205 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_TRANSPORT_UDSSENDERRESOURCE_HPP__
+#define TRANSPORT_TRANSPORT_UDSSENDERRESOURCE_HPP__
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sys/socket.h>
+#include <transport/type.h>
+#include <transport/SenderResource.h>
+#include "IPLocator.h"
+#include "UDSTransport.h"
+
+namespace transport
+{
+
+class UDSSenderResource : public SenderResource
+{
+public:
+    UDSSenderResource(
+        const Locator &locator,
+        UDSTransport &transport)
+    : SenderResource()
+    , locator_(locator)
+    {
+        send_lambda_ = [&transport](
+                            const octet *data,
+                            uint32_t dataSize,
+                            const LocatorList &locators,
+                            const std::chrono::steady_clock::time_point &max_blocking_time_point) -> bool
+        {
+            return transport.send(data, dataSize, locators, max_blocking_time_point);
+        };
+    }
+
+    virtual Locator locator() const final
+    {
+        return locator_;
+    }
+
+    virtual ~UDSSenderResource()
+    {
+    }
+
+private:
+    UDSSenderResource() = delete;
+
+    UDSSenderResource(
+        const SenderResource &) = delete;
+
+    UDSSenderResource &operator=(
+        const SenderResource &) = delete;
+
+    Locator locator_;
+};
+
+/**
+ * Sender used for UDP channels when the UDS transport is registered.
+ * Destinations on the local host are reached through the local channel of their receiver, and through the
+ * UDP channel when there is none (a peer not using the UDS transport). The datagrams carry the UDP locator
+ * of the channel, so that the receivers see the same source as through UDP.
+ * Every other destination goes through the UDP channel.
+ */
+class LocalSenderResource : public SenderResource
+{
+public:
+    LocalSenderResource(
+        std::shared_ptr<SenderResource> network_sender,
+        UDSTransport &transport)
+    : SenderResource()
+    , network_sender_(network_sender)
+    , transport_(transport)
+    , source_(network_sender->locator())
+    {
+        // The locator of the channel may leave the port to the kernel, the socket tells the actual one.
+        sockaddr_storage address;
+        socklen_t address_length = sizeof(address);
+        int fd = network_sender->native_handle();
+        if (fd >= 0 && getsockname(fd, reinterpret_cast<sockaddr *>(&address), &address_length) == 0)
+        {
+            IPLocator::createLocator(source_.kind, reinterpret_cast<const sockaddr *>(&address), source_);
+        }
+
+        send_lambda_ = [this](
+                            const octet *data,
+                            uint32_t dataSize,
+                            const LocatorList &locators,
+                            const std::chrono::steady_clock::time_point &max_blocking_time_point) -> bool
+        {
+            return send_to(data, dataSize, locators, max_blocking_time_point, nullptr);
+        };
+    }
+
+    using SenderResource::send;
+
+    virtual bool send(
+        const octet *data,
+        uint32_t dataLength,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback &release) override
+    {
+        return send_to(data, dataLength, locators, max_blocking_time_point, &release);
+    }
+
+    virtual Locator locator() const final
+    {
+        return network_sender_->locator();
+    }
+
+    virtual bool set_multicast_loopback(
+        bool enable) override
+    {
+        return network_sender_->set_multicast_loopback(enable);
+    }
+
+    virtual ~LocalSenderResource()
+    {
+    }
+
+private:
+    LocalSenderResource() = delete;
+
+    LocalSenderResource(
+        const SenderResource &) = delete;
+
+    LocalSenderResource &operator=(
+        const SenderResource &) = delete;
+
+    //! Sends to the local destinations through UDS and to the others through the network, releasing
+    //! the buffer right away when the network is not used.
+    bool send_to(
+        const octet *data,
+        uint32_t dataSize,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point,
+        const BufferReleaseCallback *release)
+    {
+        bool ret = true;
+        LocatorList network_locators;
+
+        for (const Locator &locator : locators)
+        {
+            if (!transport_.is_local_host(locator))
+            {
+                network_locators.push_back(locator);
+                continue;
+            }
+
+            // A channel bound to the wildcard address is reached at the address the destination was sent to.
+            Locator source(source_);
+            if (IPLocator::isAny(source))
+            {
+                memcpy(source.address, locator.address, sizeof(source.address));
+            }
+
+            if (!transport_.send_local(data, dataSize, source, locator, max_blocking_time_point))
+            {
+                if (errno == ENOENT || errno == ECONNREFUSED)
+                {
+                    network_locators.push_back(locator);
+                }
+                else
+                {
+                    ret = false;
+                }
+            }
+        }
+
+        if (network_locators.empty())
+        {
+            if (release)
+            {
+                (*release)(data);
+            }
+            return ret;
+        }
+
+        return (release ?
+               network_sender_->send(data, dataSize, network_locators, max_blocking_time_point, *release) :
+               network_sender_->send(data, dataSize, network_locators, max_blocking_time_point)) && ret;
+    }
+
+    std::shared_ptr<SenderResource> network_sender_;
+    UDSTransport &transport_;
+    //! UDP locator of the socket of the channel.
+    Locator source_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_TRANSPORT_UDSSENDERRESOURCE_HPP__
@@ -0,0 +1,455 @@
+// Copyright 2019 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "UDSTransport.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <uvw.hpp>
+#include <transport/TransportDescriptorInterface.h>
+#include "IPFinder.h"
+#include "IPLocator.h"
+#include "UDSReceiverResource.h"
+#include "UDSSenderResource.hpp"
+
+namespace transport
+{
+
+//! Prefix of the names of the channels, followed by the port, or by the kind, address and port of an UDP locator.
+static const char *const s_UDSNamePrefix = "tiny-transport.";
+
+//! Creates a non blocking Unix domain datagram socket.
+static int open_socket(
+    const TransportDescriptorInterface *descriptor)
+{
+    int fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    int size = static_cast<int>(descriptor->min_send_buffer_size());
+    if (size > 0)
+    {
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+
+    size = static_cast<int>(descriptor->min_recv_buffer_size());
+    if (size > 0)
+    {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    return fd;
+}
+
+UDSTransport::UDSTransport(
+    std::shared_ptr<uvw::loop> loop,
+    std::shared_ptr<TransportDescriptorInterface> descriptor)
+    : TransportInterface()
+    , loop_(loop)
+    , descriptor_(descriptor)
+    , send_fd_(-1)
+{
+}
+
+UDSTransport::~UDSTransport()
+{
+    if (send_fd_ >= 0)
+    {
+        ::close(send_fd_);
+    }
+}
+
+bool UDSTransport::init()
+{
+    send_fd_ = open_socket(descriptor_.get());
+    if (send_fd_ < 0)
+    {
+        return false;
+    }
+
+    update_network_interfaces();
+    return true;
+}
+
+socklen_t UDSTransport::socket_address(
+    const Locator &locator,
+    sockaddr_un &address)
+{
+    char name[64];
+    if (locator.kind == LOCATOR_KIND_UDS)
+    {
+        snprintf(name, sizeof(name), "%s%u", s_UDSNamePrefix, locator.port);
+    }
+    else
+    {
+        // UDP receivers bound to different addresses of the same port are different channels.
+        // IPv4 addresses take the last four bytes of the locator.
+        size_t first = locator.kind == LOCATOR_KIND_UDPv6 ? 0 : 12;
+        char hex_address[sizeof(locator.address) * 2 + 1] = {};
+        for (size_t i = first; i < sizeof(locator.address); ++i)
+        {
+            snprintf(hex_address + 2 * (i - first), 3, "%02x", locator.address[i]);
+        }
+        snprintf(name, sizeof(name), "%sudp%c-%s.%u", s_UDSNamePrefix,
+            locator.kind == LOCATOR_KIND_UDPv6 ? '6' : '4', hex_address, locator.port);
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+#if defined(__linux__)
+    // Abstract namespace: the name starts with a null byte and vanishes with the socket.
+    int length = snprintf(address.sun_path + 1, sizeof(address.sun_path) - 1, "%s", name);
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + length);
+#else
+    snprintf(address.sun_path, sizeof(address.sun_path), "/tmp/%s", name);
+    return static_cast<socklen_t>(sizeof(address));
+#endif // if defined(__linux__)
+}
+
+Locator UDSTransport::to_uds_locator(
+    const Locator &locator)
+{
+    Locator uds_locator;
+    uds_locator.kind = LOCATOR_KIND_UDS;
+    uds_locator.port = locator.port;
+    uds_locator.set_invalid_address();
+    return uds_locator;
+}
+
+bool UDSTransport::is_locator_supported(
+    const Locator &locator) const
+{
+    return locator.kind == LOCATOR_KIND_UDS;
+}
+
+Locator UDSTransport::remote_to_main_local(
+    const Locator &remote) const
+{
+    return to_uds_locator(remote);
+}
+
+bool UDSTransport::open_output_channel(
+    SendResourceList &sender_resource_list,
+    const Locator &locator)
+{
+    if (!is_locator_supported(locator))
+    {
+        return false;
+    }
+
+    // The channel is already open, the factory will hand out its sender.
+    if (std::any_of(sender_resource_list.begin(), sender_resource_list.end(), [&locator](
+                const std::shared_ptr<SenderResource> &sender)
+    {
+        return sender->locator() == locator;
+    }))
+    {
+        return true;
+    }
+
+    sender_resource_list.emplace_back(
+        static_cast<SenderResource *>(new UDSSenderResource(locator, *this))
+    );
+
+    return true;
+}
+
+bool UDSTransport::open_input_channel(
+    ReceiverResourceList &receiver_resource_list,
+    const Locator &locator,
+    uint32_t max_msg_size)
+{
+    if (!is_locator_supported(locator))
+    {
+        return false;
+    }
+
+    // The channel is already open, the factory will hand out its receiver.
+    if (std::any_of(receiver_resource_list.begin(), receiver_resource_list.end(), [&locator](
+                const std::shared_ptr<ReceiverResource> &receiver)
+    {
+        return receiver->locator() == locator;
+    }))
+    {
+        return true;
+    }
+
+    int fd = open_bound_socket(locator);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    auto recv_resource = std::make_shared<UDSReceiverResource>(this, fd, max_msg_size, locator);
+    receiver_resource_list.push_back(recv_resource);
+    recv_resource->start();
+    return true;
+}
+
+std::shared_ptr<ReceiverResource> UDSTransport::open_local_channel(
+    const Locator &locator,
+    uint32_t max_msg_size)
+{
+    int fd = open_bound_socket(locator);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    auto recv_resource = std::make_shared<UDSReceiverResource>(this, fd, max_msg_size, locator);
+    recv_resource->start();
+    return recv_resource;
+}
+
+int UDSTransport::open_bound_socket(
+    const Locator &locator)
+{
+    int fd = open_socket(descriptor_.get());
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    sockaddr_un address;
+    socklen_t address_length = socket_address(locator, address);
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&address), address_length) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool UDSTransport::do_input_locators_match(
+    const Locator &left,
+    const Locator &right) const
+{
+    return left.port == right.port;
+}
+
+LocatorList UDSTransport::normalize_locator(
+    const Locator &locator)
+{
+    LocatorList list;
+    list.push_back(to_uds_locator(locator));
+    return list;
+}
+
+TransportDescriptorInterface *UDSTransport::get_configuration()
+{
+    return descriptor_.get();
+}
+
+bool UDSTransport::default_metatraffic_multicast_locators(
+    LocatorList &locators,
+    uint32_t metatraffic_multicast_port) const
+{
+    (void)locators;
+    (void)metatraffic_multicast_port;
+    return false;
+}
+
+bool UDSTransport::default_metatraffic_unicast_locators(
+    LocatorList &locators,
+    uint32_t metatraffic_unicast_port) const
+{
+    Locator locator;
+    locator.port = metatraffic_unicast_port;
+    locators.push_back(to_uds_locator(locator));
+    return true;
+}
+
+bool UDSTransport::fill_metatraffic_multicast_locator(
+    Locator &locator,
+    uint32_t metatraffic_multicast_port) const
+{
+    (void)locator;
+    (void)metatraffic_multicast_port;
+    return false;
+}
+
+bool UDSTransport::fill_metatraffic_unicast_locator(
+    Locator &locator,
+    uint32_t metatraffic_unicast_port) const
+{
+    if (locator.port == 0)
+    {
+        locator.port = metatraffic_unicast_port;
+    }
+    return true;
+}
+
+bool UDSTransport::fill_unicast_locator(
+    Locator &locator,
+    uint32_t well_known_port) const
+{
+    if (locator.port == 0)
+    {
+        locator.port = well_known_port;
+    }
+    return true;
+}
+
+void UDSTransport::shutdown()
+{
+
+}
+
+void UDSTransport::update_network_interfaces()
+{
+    LocatorList local_addresses;
+    IPFinder::getLocalAddresses(&local_addresses);
+
+    std::lock_guard<std::mutex> lock(local_addresses_mutex_);
+    local_addresses_.swap(local_addresses);
+}
+
+bool UDSTransport::is_local_host(
+    const Locator &locator) const
+{
+    if (locator.kind != LOCATOR_KIND_UDPv4 && locator.kind != LOCATOR_KIND_UDPv6)
+    {
+        return false;
+    }
+
+    if (IPLocator::isLocal(locator))
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(local_addresses_mutex_);
+    return std::any_of(local_addresses_.begin(), local_addresses_.end(), [&locator](const Locator &address)
+    {
+        return IPLocator::compareAddress(address, locator);
+    });
+}
+
+bool UDSTransport::send(
+    const octet *send_buffer,
+    uint32_t send_buffer_size,
+    const LocatorList &locators,
+    const std::chrono::steady_clock::time_point &max_blocking_time_point)
+{
+    bool ret = true;
+
+    for (auto &locator : locators)
+    {
+        if (is_locator_supported(locator))
+        {
+            ret &= send(send_buffer, send_buffer_size, locator, max_blocking_time_point);
+        }
+    }
+
+    return ret;
+}
+
+bool UDSTransport::send(
+    const octet *send_buffer,
+    uint32_t send_buffer_size,
+    const Locator &remote_locator,
+    const std::chrono::steady_clock::time_point &max_blocking_time_point)
+{
+    sockaddr_un address;
+    iovec data = {const_cast<octet *>(send_buffer), send_buffer_size};
+    msghdr message = {};
+    message.msg_name = &address;
+    message.msg_namelen = socket_address(to_uds_locator(remote_locator), address);
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    return send_message(message, max_blocking_time_point);
+}
+
+bool UDSTransport::send_local(
+    const octet *send_buffer,
+    uint32_t send_buffer_size,
+    const Locator &source,
+    const Locator &destination,
+    const std::chrono::steady_clock::time_point &max_blocking_time_point)
+{
+    LocalSourceHeader header = {};
+    header.kind = source.kind;
+    header.port = source.port;
+    memcpy(header.address, source.address, sizeof(header.address));
+
+    iovec data[2] = {{&header, sizeof(header)}, {const_cast<octet *>(send_buffer), send_buffer_size}};
+    sockaddr_un address;
+    msghdr message = {};
+    message.msg_name = &address;
+    message.msg_namelen = socket_address(destination, address);
+    message.msg_iov = data;
+    message.msg_iovlen = 2;
+
+    if (send_message(message, max_blocking_time_point))
+    {
+        return true;
+    }
+
+    if ((errno != ENOENT && errno != ECONNREFUSED) || IPLocator::isAny(destination))
+    {
+        return false;
+    }
+
+    // Nobody is bound to the address itself, a receiver bound to the wildcard address gets the datagram.
+    Locator wildcard(destination);
+    wildcard.set_invalid_address();
+    message.msg_namelen = socket_address(wildcard, address);
+    return send_message(message, max_blocking_time_point);
+}
+
+bool UDSTransport::send_message(
+    const msghdr &message,
+    const std::chrono::steady_clock::time_point &max_blocking_time_point)
+{
+    for (;;)
+    {
+        if (::sendmsg(send_fd_, &message, 0) >= 0)
+        {
+            return true;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            max_blocking_time_point - std::chrono::steady_clock::now());
+        if ((errno != EAGAIN && errno != EWOULDBLOCK) || remaining.count() <= 0)
+        {
+            return false;
+        }
+
+        // Receiver queue full, wait until it drains or the blocking time expires.
+        pollfd descriptor = {send_fd_, POLLOUT, 0};
+        if (::poll(&descriptor, 1, static_cast<int>(remaining.count())) <= 0)
+        {
+            errno = EAGAIN;
+            return false;
+        }
+    }
+}
+
+} // namespace transport
@@ -0,0 +1,218 @@
+// Copyright 2019 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRANSPORT_UDS_TRANSPORT_H_
+#define TRANSPORT_UDS_TRANSPORT_H_
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <transport/TransportInterface.h>
+
+namespace uvw
+{
+    class loop;
+}
+
+namespace transport
+{
+
+/**
+ * Header of the datagrams of local channels: the UDP locator of the sending socket.
+ * Both ends run on the same host, so it travels in host layout.
+ */
+struct LocalSourceHeader
+{
+    int32_t kind;
+    uint32_t port;
+    octet address[16];
+};
+
+/**
+ * Unix domain datagram transport for peers running on the same host.
+ *    - A channel is identified by its port only, the address of UDS locators is always zero.
+ *
+ *    - Opening an input channel binds a SOCK_DGRAM socket to the name derived from the port
+ *      (see socket_address), and reads it from the loop.
+ *
+ *    - Output channels share a single unbound socket, datagrams are sent to the name derived
+ *      from the port of each destination.
+ *
+ *    - UDP receivers get a local channel too (see open_local_channel), named after their UDP locator,
+ *      through which the UDP senders of this host reach them (see LocalSenderResource).
+ *
+ * Datagrams through AF_UNIX skip checksums, routing and netfilter, which loopback UDP pays.
+ * @ingroup TRANSPORT_MODULE
+ */
+class UDSTransport : public TransportInterface
+{
+public:
+    UDSTransport(
+        std::shared_ptr<uvw::loop> loop,
+        std::shared_ptr<TransportDescriptorInterface> descriptor);
+
+    virtual ~UDSTransport() override;
+
+    bool init() override;
+
+    bool is_locator_supported(
+        const Locator &locator) const override;
+
+    Locator remote_to_main_local(
+        const Locator &remote) const override;
+
+    bool open_output_channel(
+        SendResourceList &sender_resource_list,
+        const Locator &locator) override;
+
+    bool open_input_channel(
+        ReceiverResourceList &receiver_resource_list,
+        const Locator &locator,
+        uint32_t max_msg_size) override;
+
+    /**
+     * Opens the local channel of an UDP receiver. Its datagrams carry the UDP locator of their sender,
+     * which the channel reports as remote locator, so that replies reach the socket of the sender.
+     * @param locator UDP locator of the receiver.
+     * @param max_msg_size Maximum size of the received messages.
+     * @return nullptr when the name is already taken, by another process for instance.
+     */
+    std::shared_ptr<ReceiverResource> open_local_channel(
+        const Locator &locator,
+        uint32_t max_msg_size);
+
+    //! Reports whether Locators correspond to the same port.
+    bool do_input_locators_match(
+        const Locator &left,
+        const Locator &right) const override;
+
+    LocatorList normalize_locator(
+        const Locator &locator) override;
+
+    TransportDescriptorInterface *get_configuration() override;
+
+    //! Unix domain sockets have no multicast.
+    bool default_metatraffic_multicast_locators(
+        LocatorList &locators,
+        uint32_t metatraffic_multicast_port) const override;
+
+    bool default_metatraffic_unicast_locators(
+        LocatorList &locators,
+        uint32_t metatraffic_unicast_port) const override;
+
+    bool fill_metatraffic_multicast_locator(
+        Locator &locator,
+        uint32_t metatraffic_multicast_port) const override;
+
+    bool fill_metatraffic_unicast_locator(
+        Locator &locator,
+        uint32_t metatraffic_unicast_port) const override;
+
+    bool fill_unicast_locator(
+        Locator &locator,
+        uint32_t well_known_port) const override;
+
+    void shutdown() override;
+
+    //! Refreshes the addresses considered to be on the local host.
+    void update_network_interfaces() override;
+
+    int32_t kind() const override
+    {
+        return LOCATOR_KIND_UDS;
+    }
+
+    /**
+     * Sends a buffer to every UDS locator of the list.
+     * @return false if any of the sends failed.
+     */
+    bool send(
+        const octet *send_buffer,
+        uint32_t send_buffer_size,
+        const LocatorList &locators,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point);
+
+    /**
+     * Sends a buffer to the channel listening on the port of the given locator.
+     * On failure errno is left as set by the socket call: ENOENT or ECONNREFUSED mean
+     * nobody listens on that port on this host.
+     */
+    bool send(
+        const octet *send_buffer,
+        uint32_t send_buffer_size,
+        const Locator &remote_locator,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point);
+
+    /**
+     * Sends a buffer to the local channel of the UDP receiver a destination reaches: the one bound to
+     * its address, or else the one bound to the wildcard address on its port, as the kernel would.
+     * On failure errno is left as set by the socket call: ENOENT or ECONNREFUSED mean there is no such
+     * receiver on this host.
+     * @param source UDP locator of the sending socket.
+     * @param destination UDP locator of the destination.
+     */
+    bool send_local(
+        const octet *send_buffer,
+        uint32_t send_buffer_size,
+        const Locator &source,
+        const Locator &destination,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point);
+
+    //! Reports whether an UDPv4 or UDPv6 locator points to an address of this host.
+    bool is_local_host(
+        const Locator &locator) const;
+
+    //! Returns the UDS locator of the channel with the same port as the given one.
+    static Locator to_uds_locator(
+        const Locator &locator);
+
+    /**
+     * Builds the name of the channel of a locator: derived from the port for UDS locators, and from
+     * the kind, address and port for the local channels of UDP locators.
+     * @return Length of the address, to be passed to bind or sendto.
+     */
+    static socklen_t socket_address(
+        const Locator &locator,
+        sockaddr_un &address);
+
+private:
+    friend class UDSReceiverResource;
+
+    //! Binds a new socket to the name of a locator, -1 on failure.
+    int open_bound_socket(
+        const Locator &locator);
+
+    //! Sends a message through the shared socket, waiting at most until the given time point.
+    bool send_message(
+        const msghdr &message,
+        const std::chrono::steady_clock::time_point &max_blocking_time_point);
+
+    std::shared_ptr<uvw::loop> loop_;
+
+    std::shared_ptr<TransportDescriptorInterface> descriptor_;
+
+    //! Unbound socket shared by every output channel.
+    int send_fd_;
+
+    //! Addresses of the local interfaces, loopback included.
+    mutable std::mutex local_addresses_mutex_;
+    LocatorList local_addresses_;
+};
+
+} // namespace transport
+
+#endif // TRANSPORT_UDS_TRANSPORT_H_
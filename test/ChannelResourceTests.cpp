@@ -0,0 +1,215 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ChannelResourceTests.cpp
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <limits>
+#include "ChannelResource.h"
+
+using namespace transport;
+
+namespace
+{
+
+class CaptureSender : public SenderResource
+{
+public:
+    CaptureSender()
+    {
+        send_lambda_ = [this](
+                            const octet *data,
+                            uint32_t size,
+                            const LocatorList &,
+                            const std::chrono::steady_clock::time_point &) -> bool
+        {
+            sent.emplace_back(data, data + size);
+            buffers.push_back(data);
+            if (on_send)
+            {
+                auto callback = std::move(on_send);
+                on_send = nullptr;
+                callback();
+            }
+            return true;
+        };
+    }
+
+    Locator locator() const override
+    {
+        return Locator();
+    }
+
+    std::vector<std::vector<octet>> sent;
+    std::vector<const octet *> buffers;
+    //! Run once, from within the next send.
+    std::function<void()> on_send;
+};
+
+class NullReceiver : public ReceiverResource
+{
+public:
+    explicit NullReceiver(
+        uint32_t max_message_size)
+        : ReceiverResource(Locator(), max_message_size)
+    {
+    }
+
+    void register_receiver(
+        const ReceiveCallback &) override
+    {
+    }
+};
+
+class ChannelResourceTests : public ::testing::Test
+{
+protected:
+    void dispatch(
+        const std::vector<octet> &datagram)
+    {
+        demultiplexer.dispatch(datagram.data(), static_cast<uint32_t>(datagram.size()), Locator(), Locator(),
+                ReceiveMetadata());
+    }
+
+    bool send(
+        const std::shared_ptr<SenderResource> &sender,
+        const std::vector<octet> &message)
+    {
+        return sender->send(message.data(), static_cast<uint32_t>(message.size()), LocatorList(),
+                       std::chrono::steady_clock::now());
+    }
+
+    //! Registers a channel collecting its messages in received.
+    std::shared_ptr<ChannelReceiverResource> listen(
+        uint32_t channel_id)
+    {
+        auto receiver = demultiplexer.channel(network_receiver, channel_id);
+        receiver->register_receiver([this, channel_id](const unsigned char *data, const uint32_t size,
+                const Locator &, const Locator &)
+        {
+            received.emplace_back(channel_id, std::vector<octet>(data, data + size));
+        });
+        return receiver;
+    }
+
+    std::shared_ptr<NullReceiver> network_receiver = std::make_shared<NullReceiver>(65500);
+    std::shared_ptr<CaptureSender> network_sender = std::make_shared<CaptureSender>();
+    ChannelDemultiplexer demultiplexer;
+    std::vector<std::pair<uint32_t, std::vector<octet>>> received;
+};
+
+} // namespace
+
+TEST_F(ChannelResourceTests, header_layout)
+{
+    auto sender = std::make_shared<ChannelSenderResource>(network_sender, 0x01020304);
+    ASSERT_TRUE(send(sender, {0xAA, 0xBB}));
+
+    ASSERT_EQ(network_sender->sent.size(), 1u);
+    EXPECT_EQ(network_sender->sent[0], std::vector<octet>({0x54, 0x43, 0, 0, 1, 2, 3, 4, 0xAA, 0xBB}));
+}
+
+TEST_F(ChannelResourceTests, datagrams_reach_their_channel_without_header)
+{
+    auto first = listen(1);
+    auto second = listen(0xFFFFFFFF);
+    auto first_sender = std::make_shared<ChannelSenderResource>(network_sender, 1);
+    auto second_sender = std::make_shared<ChannelSenderResource>(network_sender, 0xFFFFFFFF);
+
+    ASSERT_TRUE(send(second_sender, {7, 8, 9}));
+    ASSERT_TRUE(send(first_sender, {}));
+    for (const auto &datagram : network_sender->sent)
+    {
+        dispatch(datagram);
+    }
+
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(received[0].first, 0xFFFFFFFFu);
+    EXPECT_EQ(received[0].second, std::vector<octet>({7, 8, 9}));
+    EXPECT_EQ(received[1].first, 1u);
+    EXPECT_TRUE(received[1].second.empty());
+    EXPECT_EQ(demultiplexer.dropped(), 0u);
+}
+
+TEST_F(ChannelResourceTests, invalid_datagrams_are_dropped)
+{
+    auto receiver = listen(1);
+
+    // Shorter than the header, wrong magic, unknown channel.
+    dispatch({0x54, 0x43, 0, 0, 0, 0, 0});
+    dispatch({0x43, 0x54, 0, 0, 0, 0, 0, 1, 5});
+    dispatch({0x54, 0x43, 0, 0, 0, 0, 0, 2, 5});
+    EXPECT_TRUE(received.empty());
+    EXPECT_EQ(demultiplexer.dropped(), 3u);
+
+    dispatch({0x54, 0x43, 0, 0, 0, 0, 0, 1, 5});
+    ASSERT_EQ(received.size(), 1u);
+    EXPECT_EQ(received[0].second, std::vector<octet>({5}));
+}
+
+TEST_F(ChannelResourceTests, released_channel_stops_receiving)
+{
+    listen(1);
+    dispatch({0x54, 0x43, 0, 0, 0, 0, 0, 1, 5});
+    EXPECT_TRUE(received.empty());
+    EXPECT_EQ(demultiplexer.dropped(), 1u);
+}
+
+TEST_F(ChannelResourceTests, channel_is_shared_while_alive)
+{
+    auto receiver = demultiplexer.channel(network_receiver, 3);
+    EXPECT_EQ(demultiplexer.channel(network_receiver, 3), receiver);
+    EXPECT_NE(demultiplexer.channel(network_receiver, 4), receiver);
+}
+
+TEST_F(ChannelResourceTests, max_message_size_leaves_room_for_header)
+{
+    EXPECT_EQ(demultiplexer.channel(network_receiver, 1)->max_message_size(), 65500 - s_channelHeaderSize);
+
+    auto tiny = std::make_shared<NullReceiver>(s_channelHeaderSize - 1);
+    EXPECT_EQ(ChannelDemultiplexer().channel(tiny, 1)->max_message_size(), 0u);
+}
+
+TEST_F(ChannelResourceTests, oversized_message_is_rejected)
+{
+    auto sender = std::make_shared<ChannelSenderResource>(network_sender, 1);
+    octet byte = 0;
+    EXPECT_FALSE(sender->send(&byte, std::numeric_limits<uint32_t>::max() - s_channelHeaderSize + 1,
+            LocatorList(), std::chrono::steady_clock::now()));
+    EXPECT_TRUE(network_sender->sent.empty());
+}
+
+TEST_F(ChannelResourceTests, nested_send_gets_its_own_buffer)
+{
+    auto sender = std::make_shared<ChannelSenderResource>(network_sender, 1);
+    network_sender->on_send = [&]()
+    {
+        ASSERT_TRUE(send(sender, {2, 2}));
+    };
+
+    ASSERT_TRUE(send(sender, {1}));
+    ASSERT_TRUE(send(sender, {3}));
+
+    ASSERT_EQ(network_sender->sent.size(), 3u);
+    EXPECT_NE(network_sender->buffers[0], network_sender->buffers[1]);
+    // Both buffers went back to the pool, the next send reuses one of them.
+    EXPECT_TRUE(network_sender->buffers[2] == network_sender->buffers[0] ||
+            network_sender->buffers[2] == network_sender->buffers[1]);
+    EXPECT_EQ(network_sender->sent[0], std::vector<octet>({0x54, 0x43, 0, 0, 0, 0, 0, 1, 1}));
+    EXPECT_EQ(network_sender->sent[1], std::vector<octet>({0x54, 0x43, 0, 0, 0, 0, 0, 1, 2, 2}));
+    EXPECT_EQ(network_sender->sent[2], std::vector<octet>({0x54, 0x43, 0, 0, 0, 0, 0, 1, 3}));
+}
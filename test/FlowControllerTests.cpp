@@ -0,0 +1,177 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file FlowControllerTests.cpp
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <transport/FlowController.h>
+
+using namespace transport;
+using std::chrono::milliseconds;
+
+namespace
+{
+
+class CountingSender : public SenderResource
+{
+public:
+    CountingSender()
+    {
+        send_lambda_ = [this](
+                            const octet *,
+                            uint32_t size,
+                            const LocatorList &,
+                            const std::chrono::steady_clock::time_point &) -> bool
+        {
+            sizes.push_back(size);
+            return true;
+        };
+    }
+
+    Locator locator() const override
+    {
+        return Locator();
+    }
+
+    std::vector<uint32_t> sizes;
+};
+
+} // namespace
+
+TEST(TokenBucketTests, starts_full)
+{
+    TokenBucket bucket(1000, 500, std::chrono::steady_clock::time_point());
+    EXPECT_EQ(bucket.tokens(), 500);
+    EXPECT_TRUE(bucket.take(300));
+    EXPECT_TRUE(bucket.take(200));
+    EXPECT_EQ(bucket.tokens(), 0);
+    EXPECT_FALSE(bucket.take(1));
+}
+
+TEST(TokenBucketTests, refills_at_rate)
+{
+    auto start = std::chrono::steady_clock::time_point();
+    TokenBucket bucket(1000, 500, start);
+    ASSERT_TRUE(bucket.take(500));
+
+    bucket.refill(start + milliseconds(100));
+    EXPECT_EQ(bucket.tokens(), 100);
+    bucket.refill(start + milliseconds(250));
+    EXPECT_EQ(bucket.tokens(), 250);
+}
+
+TEST(TokenBucketTests, refill_is_capped_at_burst)
+{
+    auto start = std::chrono::steady_clock::time_point();
+    TokenBucket bucket(1000, 500, start);
+    ASSERT_TRUE(bucket.take(100));
+
+    bucket.refill(start + milliseconds(900));
+    EXPECT_EQ(bucket.tokens(), 500);
+
+    // A long pause is credited as one second at most.
+    ASSERT_TRUE(bucket.take(500));
+    bucket.refill(start + std::chrono::hours(1));
+    EXPECT_EQ(bucket.tokens(), 500);
+}
+
+TEST(TokenBucketTests, fractions_of_a_byte_are_not_lost)
+{
+    auto start = std::chrono::steady_clock::time_point();
+    TokenBucket bucket(10, 100, start);
+    ASSERT_TRUE(bucket.take(100));
+
+    // 10 bytes per second earn a byte every 100 ms: ticks of 40 ms must not discard the partial bytes.
+    for (int tick = 1; tick <= 5; ++tick)
+    {
+        bucket.refill(start + milliseconds(40 * tick));
+    }
+    EXPECT_EQ(bucket.tokens(), 2);
+}
+
+TEST(TokenBucketTests, oversized_message_needs_a_full_bucket)
+{
+    auto start = std::chrono::steady_clock::time_point();
+    TokenBucket bucket(1000, 500, start);
+    ASSERT_TRUE(bucket.take(1));
+    EXPECT_FALSE(bucket.take(800));
+
+    bucket.refill(start + milliseconds(1));
+    ASSERT_TRUE(bucket.take(800));
+    EXPECT_EQ(bucket.tokens(), -300);
+
+    // The debt is paid before anything else goes through.
+    bucket.refill(start + milliseconds(301));
+    EXPECT_EQ(bucket.tokens(), 0);
+    EXPECT_FALSE(bucket.take(1));
+}
+
+TEST(TokenBucketTests, give_back_is_capped_at_burst)
+{
+    TokenBucket bucket(1000, 500, std::chrono::steady_clock::time_point());
+    ASSERT_TRUE(bucket.take(200));
+    bucket.give_back(200);
+    EXPECT_EQ(bucket.tokens(), 500);
+    bucket.give_back(200);
+    EXPECT_EQ(bucket.tokens(), 500);
+}
+
+TEST(FlowControllerTests, unlimited_controller_sends_right_away)
+{
+    auto controller = std::make_shared<FlowController>(FlowControllerConfig());
+    auto network_sender = std::make_shared<CountingSender>();
+    auto sender = controller->attach(network_sender);
+
+    std::vector<octet> message(100000);
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_TRUE(sender->send(message.data(), static_cast<uint32_t>(message.size()), LocatorList(),
+                std::chrono::steady_clock::now()));
+    }
+    EXPECT_EQ(network_sender->sizes.size(), 10u);
+}
+
+TEST(FlowControllerTests, messages_beyond_burst_are_queued)
+{
+    FlowControllerConfig config;
+    config.bytes_per_second = 1;
+    config.burst_size = 300;
+    config.queue_depth = 2;
+    auto controller = std::make_shared<FlowController>(config);
+    auto network_sender = std::make_shared<CountingSender>();
+    auto sender = controller->attach(network_sender);
+
+    std::vector<octet> message(100);
+    auto send = [&]()
+    {
+        return sender->send(message.data(), static_cast<uint32_t>(message.size()), LocatorList(),
+                       std::chrono::steady_clock::now());
+    };
+
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_TRUE(send());
+    }
+    EXPECT_EQ(network_sender->sizes.size(), 3u);
+
+    // No timer is driving this controller: the next messages wait in the queue until it is full.
+    EXPECT_TRUE(send());
+    EXPECT_TRUE(send());
+    EXPECT_FALSE(send());
+    EXPECT_EQ(network_sender->sizes.size(), 3u);
+    EXPECT_EQ(controller->dropped(), 0u);
+}
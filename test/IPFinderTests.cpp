@@ -0,0 +1,130 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file IPFinderTests.cpp
+ *
+ */
+
+#include <gtest/gtest.h>
+#include "IPFinder.h"
+
+using namespace transport;
+
+namespace
+{
+
+IPFinder::info_IP make_ip(
+    const std::string &address,
+    const std::string &dev = "eth0")
+{
+    IPFinder::info_IP info;
+    info.name = address;
+    info.dev = dev;
+    if (address.find(':') == std::string::npos)
+    {
+        info.type = IPFinder::IP4;
+        IPFinder::parseIP4(info);
+    }
+    else
+    {
+        info.type = IPFinder::IP6;
+        IPFinder::parseIP6(info);
+    }
+    return info;
+}
+
+} // namespace
+
+TEST(IPFinderTests, matches_interface_name)
+{
+    EXPECT_TRUE(IPFinder::matchesInterface(make_ip("192.168.1.10", "eth1"), "eth1"));
+    EXPECT_FALSE(IPFinder::matchesInterface(make_ip("192.168.1.10", "eth1"), "eth0"));
+}
+
+TEST(IPFinderTests, matches_exact_address)
+{
+    EXPECT_TRUE(IPFinder::matchesInterface(make_ip("192.168.1.10"), "192.168.1.10"));
+    EXPECT_FALSE(IPFinder::matchesInterface(make_ip("192.168.1.10"), "192.168.1.11"));
+    EXPECT_TRUE(IPFinder::matchesInterface(make_ip("fd00::1"), "fd00::1"));
+    EXPECT_FALSE(IPFinder::matchesInterface(make_ip("fd00::1"), "fd00::2"));
+}
+
+TEST(IPFinderTests, matches_ipv4_blocks)
+{
+    auto ip = make_ip("10.1.2.3");
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "10.0.0.0/8"));
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "10.1.0.0/16"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.2.0.0/16"));
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "10.1.2.3/32"));
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "0.0.0.0/0"));
+
+    // Prefixes not on a byte boundary: 10.1.2.3 is in 10.1.0.0/22, not in 10.1.4.0/22.
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "10.1.0.0/22"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.1.4.0/22"));
+    EXPECT_TRUE(IPFinder::matchesInterface(make_ip("172.31.255.255"), "172.16.0.0/12"));
+    EXPECT_FALSE(IPFinder::matchesInterface(make_ip("172.32.0.0"), "172.16.0.0/12"));
+}
+
+TEST(IPFinderTests, matches_ipv6_blocks)
+{
+    auto ip = make_ip("fd12:3456::1");
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "fd00::/8"));
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "fd12:3400::/23"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "fd12:3600::/23"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "fe80::/10"));
+    EXPECT_TRUE(IPFinder::matchesInterface(ip, "fd12:3456::1/128"));
+}
+
+TEST(IPFinderTests, families_do_not_mix)
+{
+    EXPECT_FALSE(IPFinder::matchesInterface(make_ip("10.1.2.3"), "::/0"));
+    EXPECT_FALSE(IPFinder::matchesInterface(make_ip("fd00::1"), "0.0.0.0/0"));
+}
+
+TEST(IPFinderTests, malformed_filters_match_nothing)
+{
+    auto ip = make_ip("10.1.2.3");
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.0.0.0/"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.0.0.0/abc"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.0.0.0/-8"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.0.0.0/33"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.0.0.0/8x"));
+    EXPECT_FALSE(IPFinder::matchesInterface(ip, "10.0.0/8"));
+    EXPECT_FALSE(IPFinder::matchesInterface(make_ip("fd00::1"), "fd00::/129"));
+}
+
+TEST(IPFinderTests, empty_lists_allow_everything)
+{
+    EXPECT_TRUE(IPFinder::isInterfaceAllowed(make_ip("10.1.2.3"), {}, {}));
+}
+
+TEST(IPFinderTests, whitelist_restricts)
+{
+    std::vector<std::string> whitelist = {"lo", "192.168.0.0/16"};
+    EXPECT_TRUE(IPFinder::isInterfaceAllowed(make_ip("192.168.7.1"), whitelist, {}));
+    EXPECT_TRUE(IPFinder::isInterfaceAllowed(make_ip("127.0.0.1", "lo"), whitelist, {}));
+    EXPECT_FALSE(IPFinder::isInterfaceAllowed(make_ip("10.1.2.3"), whitelist, {}));
+}
+
+TEST(IPFinderTests, blacklist_wins_over_whitelist)
+{
+    std::vector<std::string> whitelist = {"10.0.0.0/8"};
+    std::vector<std::string> blacklist = {"10.1.0.0/16", "docker0"};
+    EXPECT_TRUE(IPFinder::isInterfaceAllowed(make_ip("10.2.0.1"), whitelist, blacklist));
+    EXPECT_FALSE(IPFinder::isInterfaceAllowed(make_ip("10.1.0.1"), whitelist, blacklist));
+    EXPECT_FALSE(IPFinder::isInterfaceAllowed(make_ip("10.2.0.1", "docker0"), whitelist, blacklist));
+    EXPECT_FALSE(IPFinder::isInterfaceAllowed(make_ip("10.2.0.1", "docker0"), {}, blacklist));
+    EXPECT_TRUE(IPFinder::isInterfaceAllowed(make_ip("192.168.0.1"), {}, blacklist));
+}
@@ -0,0 +1,297 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ReliableResourceTests.cpp
+ *
+ */
+
+#include <gtest/gtest.h>
+#include "ReliableResource.h"
+
+using namespace transport;
+
+namespace
+{
+
+//! Keeps every datagram instead of sending it.
+class CaptureSender : public SenderResource
+{
+public:
+    CaptureSender()
+    {
+        send_lambda_ = [this](
+                            const octet *data,
+                            uint32_t size,
+                            const LocatorList &,
+                            const std::chrono::steady_clock::time_point &) -> bool
+        {
+            sent.emplace_back(data, data + size);
+            return true;
+        };
+    }
+
+    Locator locator() const override
+    {
+        return Locator();
+    }
+
+    std::vector<std::vector<octet>> sent;
+};
+
+class NullReceiver : public ReceiverResource
+{
+public:
+    NullReceiver()
+        : ReceiverResource(Locator(), 65500)
+    {
+    }
+
+    void register_receiver(
+        const ReceiveCallback &) override
+    {
+    }
+};
+
+uint64_t read_be64(
+    const std::vector<octet> &buffer,
+    size_t offset)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        value = (value << 8) | buffer[offset + i];
+    }
+    return value;
+}
+
+//! NACK base sequence and bitmap.
+std::pair<uint64_t, uint64_t> parse_nack(
+    const std::vector<octet> &message)
+{
+    EXPECT_EQ(message.size(), s_reliableControlSize);
+    EXPECT_EQ(message[2], 3);
+    return {read_be64(message, 8), read_be64(message, s_reliableHeaderSize)};
+}
+
+class ReliableResourceTests : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        create(ReliabilityConfig());
+    }
+
+    void create(
+        const ReliabilityConfig &config)
+    {
+        network_sender = std::make_shared<CaptureSender>();
+        nack_sender = std::make_shared<CaptureSender>();
+        writer = std::make_shared<ReliableSenderResource>(network_sender, config);
+        reader = std::make_shared<ReliableReceiverResource>(std::make_shared<NullReceiver>(), nack_sender, config);
+        reader->register_receiver([this](const unsigned char *data, const uint32_t size, const Locator &,
+                const Locator &)
+        {
+            delivered.push_back(data[0]);
+            EXPECT_EQ(size, 1u);
+        });
+    }
+
+    //! Writes messages carrying first..last, returns the datagrams sent by the writer.
+    std::vector<std::vector<octet>> write(
+        octet first,
+        octet last)
+    {
+        LocatorList destinations;
+        destinations.push_back(Locator());
+        network_sender->sent.clear();
+        for (octet value = first; value <= last; ++value)
+        {
+            EXPECT_TRUE(writer->send(&value, 1, destinations, std::chrono::steady_clock::now()));
+        }
+        return network_sender->sent;
+    }
+
+    void receive(
+        const std::vector<octet> &datagram)
+    {
+        reader->on_message(datagram.data(), static_cast<uint32_t>(datagram.size()), Locator(), Locator(),
+                ReceiveMetadata());
+    }
+
+    std::shared_ptr<CaptureSender> network_sender;
+    std::shared_ptr<CaptureSender> nack_sender;
+    std::shared_ptr<ReliableSenderResource> writer;
+    std::shared_ptr<ReliableReceiverResource> reader;
+    std::vector<octet> delivered;
+};
+
+} // namespace
+
+TEST_F(ReliableResourceTests, data_carries_consecutive_sequence_numbers)
+{
+    auto datagrams = write(1, 3);
+    ASSERT_EQ(datagrams.size(), 3u);
+    for (uint64_t i = 0; i < datagrams.size(); ++i)
+    {
+        ASSERT_EQ(datagrams[i].size(), s_reliableHeaderSize + 1);
+        EXPECT_EQ(datagrams[i][2], 1);
+        EXPECT_EQ(read_be64(datagrams[i], 8), i + 1);
+        EXPECT_EQ(datagrams[i][s_reliableHeaderSize], i + 1);
+    }
+}
+
+TEST_F(ReliableResourceTests, out_of_order_messages_are_delivered_in_sequence)
+{
+    auto datagrams = write(1, 4);
+    receive(datagrams[0]);
+    receive(datagrams[2]);
+    receive(datagrams[3]);
+    EXPECT_EQ(delivered, std::vector<octet>({1}));
+
+    receive(datagrams[1]);
+    EXPECT_EQ(delivered, std::vector<octet>({1, 2, 3, 4}));
+    EXPECT_EQ(reader->statistics().lost_messages, 0u);
+}
+
+TEST_F(ReliableResourceTests, duplicates_are_delivered_once)
+{
+    auto datagrams = write(1, 2);
+    receive(datagrams[0]);
+    receive(datagrams[0]);
+    receive(datagrams[1]);
+    receive(datagrams[1]);
+    EXPECT_EQ(delivered, std::vector<octet>({1, 2}));
+}
+
+TEST_F(ReliableResourceTests, nack_bitmap_marks_missing_sequences)
+{
+    auto datagrams = write(1, 6);
+    receive(datagrams[0]);
+    receive(datagrams[2]);
+    receive(datagrams[5]);
+
+    // 2, 4 and 5 are missing, relative to the first undelivered message.
+    ASSERT_FALSE(nack_sender->sent.empty());
+    auto nack = parse_nack(nack_sender->sent.back());
+    EXPECT_EQ(nack.first, 2u);
+    EXPECT_EQ(nack.second, 0b1101u);
+}
+
+TEST_F(ReliableResourceTests, nack_is_answered_from_history)
+{
+    auto datagrams = write(1, 4);
+    receive(datagrams[0]);
+    receive(datagrams[3]);
+    ASSERT_FALSE(nack_sender->sent.empty());
+
+    auto nack = nack_sender->sent.back();
+    network_sender->sent.clear();
+    writer->on_control(nack.data(), static_cast<uint32_t>(nack.size()), Locator());
+    ASSERT_EQ(network_sender->sent.size(), 2u);
+    EXPECT_EQ(network_sender->sent[0], datagrams[1]);
+    EXPECT_EQ(network_sender->sent[1], datagrams[2]);
+
+    for (const auto &retransmission : std::vector<std::vector<octet>>(network_sender->sent))
+    {
+        receive(retransmission);
+    }
+    EXPECT_EQ(delivered, std::vector<octet>({1, 2, 3, 4}));
+}
+
+TEST_F(ReliableResourceTests, heartbeat_reveals_trailing_losses)
+{
+    auto datagrams = write(1, 3);
+    receive(datagrams[0]);
+    EXPECT_TRUE(nack_sender->sent.empty());
+
+    network_sender->sent.clear();
+    writer->send_heartbeat();
+    ASSERT_EQ(network_sender->sent.size(), 1u);
+    auto heartbeat = network_sender->sent[0];
+    EXPECT_EQ(heartbeat[2], 2);
+    EXPECT_EQ(read_be64(heartbeat, 8), 3u);
+    EXPECT_EQ(read_be64(heartbeat, s_reliableHeaderSize), 1u);
+
+    receive(heartbeat);
+    ASSERT_EQ(nack_sender->sent.size(), 1u);
+    auto nack = parse_nack(nack_sender->sent.back());
+    EXPECT_EQ(nack.first, 2u);
+    EXPECT_EQ(nack.second, 0b11u);
+}
+
+TEST_F(ReliableResourceTests, messages_out_of_history_are_given_up)
+{
+    ReliabilityConfig config;
+    config.history_depth = 2;
+    create(config);
+
+    auto datagrams = write(1, 5);
+    receive(datagrams[0]);
+
+    network_sender->sent.clear();
+    writer->send_heartbeat();
+    ASSERT_EQ(network_sender->sent.size(), 1u);
+    EXPECT_EQ(read_be64(network_sender->sent[0], s_reliableHeaderSize), 4u);
+
+    receive(network_sender->sent[0]);
+    EXPECT_EQ(reader->statistics().lost_messages, 2u);
+    auto nack = parse_nack(nack_sender->sent.back());
+    EXPECT_EQ(nack.first, 4u);
+    EXPECT_EQ(nack.second, 0b11u);
+
+    receive(datagrams[3]);
+    receive(datagrams[4]);
+    EXPECT_EQ(delivered, std::vector<octet>({1, 4, 5}));
+}
+
+TEST_F(ReliableResourceTests, window_overflow_skips_the_oldest_gap)
+{
+    ReliabilityConfig config;
+    config.window_depth = 4;
+    create(config);
+
+    auto datagrams = write(1, 8);
+    receive(datagrams[0]);
+    receive(datagrams[2]);
+
+    // 8 only fits once the window starts at 5: 2 and 4 are lost, 3 is delivered on the way.
+    receive(datagrams[7]);
+    EXPECT_EQ(delivered, std::vector<octet>({1, 3}));
+    EXPECT_EQ(reader->statistics().lost_messages, 2u);
+
+    receive(datagrams[4]);
+    receive(datagrams[5]);
+    receive(datagrams[6]);
+    EXPECT_EQ(delivered, std::vector<octet>({1, 3, 5, 6, 7, 8}));
+}
+
+TEST_F(ReliableResourceTests, late_joiner_starts_at_first_message_seen)
+{
+    auto datagrams = write(1, 3);
+    receive(datagrams[1]);
+    receive(datagrams[2]);
+    EXPECT_EQ(delivered, std::vector<octet>({2, 3}));
+    EXPECT_TRUE(nack_sender->sent.empty());
+}
+
+TEST_F(ReliableResourceTests, foreign_datagrams_are_ignored)
+{
+    std::vector<octet> garbage(s_reliableControlSize, 0xAB);
+    receive(garbage);
+    writer->on_control(garbage.data(), static_cast<uint32_t>(garbage.size()), Locator());
+    EXPECT_TRUE(delivered.empty());
+    EXPECT_TRUE(network_sender->sent.empty());
+    EXPECT_TRUE(nack_sender->sent.empty());
+}
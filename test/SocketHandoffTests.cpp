@@ -0,0 +1,222 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file SocketHandoffTests.cpp
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <future>
+#include "SocketHandoff.h"
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace transport;
+using std::chrono::milliseconds;
+
+namespace
+{
+
+class SocketHandoffTests : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        path = "/tmp/transport_handoff_test_" + std::to_string(::getpid());
+        ::unlink(path.c_str());
+    }
+
+    void TearDown() override
+    {
+        ::unlink(path.c_str());
+        for (int fd : fds)
+        {
+            ::close(fd);
+        }
+    }
+
+    int udp_socket()
+    {
+        int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        fds.push_back(fd);
+        return fd;
+    }
+
+    //! Accepts the adopting process on path and sends it a raw record instead of a handoff one.
+    std::future<void> serve_raw_record(
+        const std::vector<char> &record)
+    {
+        int listener = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        memcpy(address.sun_path, path.c_str(), path.size());
+        EXPECT_EQ(::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)), 0);
+        EXPECT_EQ(::listen(listener, 1), 0);
+
+        return std::async(std::launch::async, [listener, record]()
+        {
+            int peer = ::accept(listener, nullptr, nullptr);
+            ::send(peer, record.data(), record.size(), 0);
+            ::close(peer);
+            ::close(listener);
+        });
+    }
+
+    static ino_t inode(
+        int fd)
+    {
+        struct stat status;
+        EXPECT_EQ(::fstat(fd, &status), 0);
+        return status.st_ino;
+    }
+
+    std::string path;
+    std::vector<int> fds;
+};
+
+} // namespace
+
+TEST_F(SocketHandoffTests, records_keep_their_fields)
+{
+    std::vector<HandoffSocket> exported(2);
+    exported[0].locator.kind = LOCATOR_KIND_UDPv4;
+    exported[0].locator.port = 7400;
+    exported[0].locator.address[12] = 239;
+    exported[0].locator.address[15] = 1;
+    exported[0].input = true;
+    exported[0].priority = TrafficPriority::HIGH;
+    exported[0].fd = udp_socket();
+    exported[1].locator.kind = LOCATOR_KIND_UDPv6;
+    exported[1].locator.port = 7411;
+    exported[1].locator.address[0] = 0xfd;
+    exported[1].fd = udp_socket();
+
+    auto sent = std::async(std::launch::async, [&]()
+    {
+        return SocketHandoff::send(path, exported, milliseconds(5000));
+    });
+
+    std::vector<HandoffSocket> adopted;
+    ASSERT_TRUE(SocketHandoff::receive(path, adopted, milliseconds(5000)));
+    ASSERT_TRUE(sent.get());
+    ASSERT_EQ(adopted.size(), exported.size());
+
+    for (size_t i = 0; i < adopted.size(); ++i)
+    {
+        fds.push_back(adopted[i].fd);
+        EXPECT_EQ(adopted[i].locator, exported[i].locator);
+        EXPECT_EQ(adopted[i].input, exported[i].input);
+        EXPECT_EQ(adopted[i].priority, exported[i].priority);
+        EXPECT_NE(adopted[i].fd, exported[i].fd);
+        EXPECT_EQ(inode(adopted[i].fd), inode(exported[i].fd));
+    }
+
+    // The listening socket is removed once the transfer is done.
+    EXPECT_NE(::access(path.c_str(), F_OK), 0);
+}
+
+TEST_F(SocketHandoffTests, empty_list_is_complete)
+{
+    auto sent = std::async(std::launch::async, [&]()
+    {
+        return SocketHandoff::send(path, std::vector<HandoffSocket>(), milliseconds(5000));
+    });
+
+    std::vector<HandoffSocket> adopted;
+    EXPECT_TRUE(SocketHandoff::receive(path, adopted, milliseconds(5000)));
+    EXPECT_TRUE(sent.get());
+    EXPECT_TRUE(adopted.empty());
+}
+
+TEST_F(SocketHandoffTests, short_record_fails_the_handoff)
+{
+    auto served = serve_raw_record({1, 2, 3});
+    std::vector<HandoffSocket> adopted;
+    EXPECT_FALSE(SocketHandoff::receive(path, adopted, milliseconds(5000)));
+    served.get();
+    EXPECT_TRUE(adopted.empty());
+}
+
+TEST_F(SocketHandoffTests, record_without_descriptor_fails_the_handoff)
+{
+    // Right size and version, but no SCM_RIGHTS attached.
+    std::vector<char> record(sizeof(uint32_t) * 3 + 16 + 2 + 2, 0);
+    uint32_t version = 1;
+    memcpy(record.data(), &version, sizeof(version));
+    auto served = serve_raw_record(record);
+
+    std::vector<HandoffSocket> adopted;
+    EXPECT_FALSE(SocketHandoff::receive(path, adopted, milliseconds(5000)));
+    served.get();
+    EXPECT_TRUE(adopted.empty());
+}
+
+TEST_F(SocketHandoffTests, receive_times_out_without_exporter)
+{
+    std::vector<HandoffSocket> adopted;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(SocketHandoff::receive(path, adopted, milliseconds(50)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(50));
+}
+
+TEST_F(SocketHandoffTests, send_times_out_without_adopter)
+{
+    EXPECT_FALSE(SocketHandoff::send(path, std::vector<HandoffSocket>(), milliseconds(50)));
+    EXPECT_NE(::access(path.c_str(), F_OK), 0);
+}
+
+TEST_F(SocketHandoffTests, stale_socket_is_replaced)
+{
+    int stale = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size());
+    ASSERT_EQ(::bind(stale, reinterpret_cast<const sockaddr *>(&address), sizeof(address)), 0);
+    ::close(stale);
+
+    auto sent = std::async(std::launch::async, [&]()
+    {
+        return SocketHandoff::send(path, std::vector<HandoffSocket>(), milliseconds(5000));
+    });
+
+    std::vector<HandoffSocket> adopted;
+    EXPECT_TRUE(SocketHandoff::receive(path, adopted, milliseconds(5000)));
+    EXPECT_TRUE(sent.get());
+}
+
+TEST_F(SocketHandoffTests, other_files_are_not_removed)
+{
+    std::ofstream(path) << "keep";
+    EXPECT_FALSE(SocketHandoff::send(path, std::vector<HandoffSocket>(), milliseconds(50)));
+
+    std::string content;
+    std::ifstream(path) >> content;
+    EXPECT_EQ(content, "keep");
+}
+
+TEST_F(SocketHandoffTests, path_too_long_is_rejected)
+{
+    std::string long_path(sizeof(sockaddr_un().sun_path), 'a');
+    std::vector<HandoffSocket> adopted;
+    EXPECT_FALSE(SocketHandoff::send(long_path, std::vector<HandoffSocket>(), milliseconds(50)));
+    EXPECT_FALSE(SocketHandoff::receive(long_path, adopted, milliseconds(50)));
+}
+
+#endif // defined(__linux__)
@@ -0,0 +1,160 @@
+// Copyright 2016 Proyectos y Sistemas de Mantenimiento SL (eProsima).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file ZeroCopySocketTests.cpp
+ *
+ */
+
+#include <gtest/gtest.h>
+#include "udp/ZeroCopySocket.h"
+
+using namespace transport;
+
+namespace
+{
+
+class ZeroCopySocketTests : public ::testing::Test
+{
+protected:
+    //! Tracks a message of the given number of datagrams, identified by the address of buffers[index].
+    void track(
+        uint32_t datagrams)
+    {
+        size_t index = messages.size() + finished_count();
+        messages.push_back(ZeroCopySocket::Message{next_id, datagrams, datagrams, &buffers[index], nullptr});
+        next_id += datagrams;
+    }
+
+    //! Indexes of the messages finished so far, in the order they were reported.
+    std::vector<size_t> complete(
+        uint32_t low,
+        uint32_t high)
+    {
+        std::vector<ZeroCopySocket::Message> now_finished;
+        ZeroCopySocket::complete(messages, low, high, now_finished);
+
+        std::vector<size_t> indexes;
+        for (const ZeroCopySocket::Message &message : now_finished)
+        {
+            indexes.push_back(static_cast<size_t>(message.data - buffers));
+        }
+        finished.insert(finished.end(), indexes.begin(), indexes.end());
+        return indexes;
+    }
+
+    size_t finished_count() const
+    {
+        return finished.size();
+    }
+
+    octet buffers[16] = {};
+    uint32_t next_id = 0;
+    std::deque<ZeroCopySocket::Message> messages;
+    std::vector<size_t> finished;
+};
+
+} // namespace
+
+TEST_F(ZeroCopySocketTests, exact_range_finishes_message)
+{
+    track(3);
+    EXPECT_EQ(complete(0, 2), std::vector<size_t>({0}));
+    EXPECT_TRUE(messages.empty());
+}
+
+TEST_F(ZeroCopySocketTests, range_spanning_messages_finishes_them_in_order)
+{
+    track(1);
+    track(2);
+    track(3);
+    EXPECT_EQ(complete(0, 5), std::vector<size_t>({0, 1, 2}));
+    EXPECT_TRUE(messages.empty());
+}
+
+TEST_F(ZeroCopySocketTests, partial_range_keeps_message_in_flight)
+{
+    track(4);
+    track(1);
+    EXPECT_TRUE(complete(0, 1).empty());
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0].remaining, 2u);
+    EXPECT_EQ(messages[1].remaining, 1u);
+
+    // A range ending in the middle of the second message does not finish it.
+    EXPECT_EQ(complete(2, 3), std::vector<size_t>({0}));
+    EXPECT_EQ(complete(4, 4), std::vector<size_t>({1}));
+}
+
+TEST_F(ZeroCopySocketTests, later_message_may_finish_first)
+{
+    track(2);
+    track(2);
+    track(2);
+    EXPECT_EQ(complete(2, 3), std::vector<size_t>({1}));
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0].remaining, 2u);
+    EXPECT_EQ(messages[1].remaining, 2u);
+
+    EXPECT_EQ(complete(0, 1), std::vector<size_t>({0}));
+    EXPECT_EQ(complete(4, 5), std::vector<size_t>({2}));
+}
+
+TEST_F(ZeroCopySocketTests, range_across_message_boundaries)
+{
+    track(3);
+    track(3);
+    EXPECT_TRUE(complete(1, 4).empty());
+    EXPECT_EQ(messages[0].remaining, 1u);
+    EXPECT_EQ(messages[1].remaining, 1u);
+    EXPECT_EQ(complete(0, 0), std::vector<size_t>({0}));
+    EXPECT_EQ(complete(5, 5), std::vector<size_t>({1}));
+}
+
+TEST_F(ZeroCopySocketTests, counter_wraps_around)
+{
+    next_id = 0xFFFFFFFE;
+    track(1);
+    track(3);
+    track(1);
+    EXPECT_EQ(complete(0xFFFFFFFE, 1), std::vector<size_t>({0, 1}));
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0].first, 2u);
+    EXPECT_EQ(complete(2, 2), std::vector<size_t>({2}));
+}
+
+TEST_F(ZeroCopySocketTests, values_before_oldest_message_are_ignored)
+{
+    next_id = 10;
+    track(2);
+
+    // Values 6 to 9 belonged to messages already released.
+    EXPECT_TRUE(complete(6, 9).empty());
+    EXPECT_EQ(messages[0].remaining, 2u);
+    EXPECT_EQ(complete(6, 10).size(), 0u);
+    EXPECT_EQ(messages[0].remaining, 1u);
+    EXPECT_EQ(complete(11, 11), std::vector<size_t>({0}));
+}
+
+TEST_F(ZeroCopySocketTests, values_after_newest_message_are_ignored)
+{
+    track(2);
+    EXPECT_EQ(complete(0, 100), std::vector<size_t>({0}));
+    EXPECT_TRUE(messages.empty());
+}
+
+TEST_F(ZeroCopySocketTests, nothing_in_flight)
+{
+    EXPECT_TRUE(complete(0, 10).empty());
+}